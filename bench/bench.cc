@@ -1,11 +1,10 @@
 /*
-TODO:
-    - add persistency
-    - include load factor
-    - Move up directory
-    - get memory footprint of all the operations
-    - add realistic use-cases
-    - add erase existing int
+The core suite compares stroupo::hash_map with std::unordered_map and
+boost::unordered_map for the basic operations. Every case is warmed up and
+repeated, see harness.h. The workloads suite replays skewed and mixed
+sequences of operations on the same maps, see workloads.h. The experiments
+compare the policies of stroupo and are warmed up and repeated the same way.
+The memory suite counts the heap memory of the maps with CountingAllocator.
 */
 
 #include<unordered_map>
@@ -23,15 +22,18 @@ TODO:
 #include<algorithm>
 #include<utility>
 #include<cstdlib>
+#include <hash_map/frozen_hash_map.h>
+#include <hash_map/hash.h>
 #include <hash_map/hash_map.h>
+#include <hash_map/mapped_hash_map.h>
+#include "harness.h"
+#include "workloads.h"
 
 
 typedef double Time;
 typedef std::string KeyType;
-typedef std::vector<Time> Timings;
-typedef std::vector<std::pair<int, std::vector<Time>>> TimingResults;
-boost::filesystem::path full_path( boost::filesystem::current_path() );
-std::string img_path = full_path.string();
+typedef std::vector<Statistics> Timings;
+typedef std::vector<std::pair<int, Timings>> TimingResults;
 
 struct Range
 {
@@ -60,21 +62,105 @@ auto mf_sequential_lookups(
 	std::vector<typename HashMap::key_type> &keyvec)
 {
 	return [&hm, &keyvec](){
+		std::size_t found = 0;
 		for(auto key : keyvec)
 		{
-			hm.find(key);
+			found += hm.find(key) != hm.end();
 		}
+		benchmark_sink = found;
 	};
 }
 
+template<typename HashMap>
+auto mf_sequential_erasures(
+	HashMap &hm,
+	std::vector<typename HashMap::key_type> &keyvec)
+{
+	return [&hm, &keyvec](){
+		for(auto key : keyvec)
+		{
+			hm.erase(key);
+		}
+	};
+}
+template<typename HashMap>
+auto mf_mixed_insert_erase(
+	HashMap &hm,
+	std::vector<typename HashMap::key_type> &keyvec)
+{
+	// keeps a sliding window of the last keyvec.size() / 4 keys in the map
+	return [&hm, &keyvec](){
+		const std::size_t window = keyvec.size() / 4;
+		for(std::size_t i = 0; i < keyvec.size(); ++i)
+		{
+			hm.insert({keyvec[i], 0});
+			if(i >= window) hm.erase(keyvec[i - window]);
+		}
+	};
+}
+
+// the results are stored, otherwise the lookups could be optimized away
+template<typename HashMap>
+auto mf_single_contains(
+	HashMap &hm,
+	std::vector<typename HashMap::key_type> &keyvec,
+	std::vector<char> &found)
+{
+	return [&hm, &keyvec, &found](){
+		std::size_t hits = 0;
+		for(std::size_t i = 0; i < keyvec.size(); ++i)
+		{
+			found[i] = hm.contains(keyvec[i]);
+			hits += found[i];
+		}
+		benchmark_sink = hits;
+	};
+}
+template<typename HashMap>
+auto mf_batch_contains(
+	HashMap &hm,
+	std::vector<typename HashMap::key_type> &keyvec,
+	std::vector<char> &found)
+{
+	return [&hm, &keyvec, &found](){
+		hm.contains_batch(keyvec.begin(), keyvec.end(), found.begin());
+		benchmark_sink = std::count(found.begin(), found.end(), 1);
+	};
+}
+
+// a function of the experiments, which is measured as a whole in every
+// repetition as it needs no setup
 template <typename Function>
-Time measure(Function function, int repetitions = 1)
+auto timed(Function function)
+{
+	return [function](Timer &timer){
+		timer.start();
+		function();
+		timer.stop();
+	};
+}
+// the insertions into an empty map, which is created in every repetition
+template <typename HashMap>
+Statistics measure_insertion(const Options &options,
+							 std::vector<typename HashMap::key_type> &keyvec)
+{
+	return measure(options, keyvec.size(), [&](Timer &timer){
+		HashMap hm;
+		timer.start();
+		mf_sequential_insertion(hm, keyvec)();
+		timer.stop();
+		benchmark_sink = hm.size();
+	});
+}
+// Converts the nanoseconds of a measurement which processed the given bytes
+// into GB/s. Hence, the 99th percentile is the throughput of the slowest
+// repetitions, the minimum the one of the fastest and the mean the one of all
+// repetitions together.
+Statistics throughput(Statistics ns, double bytes)
 {
-	auto start = std::chrono::high_resolution_clock::now();
-	function();
-    auto end = std::chrono::high_resolution_clock::now();
-    auto diff = end - start;
-    return std::chrono::duration<Time>(diff).count();
+	for(double *value : {&ns.median, &ns.p99, &ns.mean, &ns.min})
+		*value = bytes / *value;
+	return ns;
 }
 struct MakeUniqueString
 {
@@ -160,160 +246,1018 @@ std::vector<T> range(Range &r)
 	return vec;
 }
 
+
 template<typename T, class... HashMaps>
-Timings time_sequential_insert_h(int size, float non_unique, HashMaps... hms)
+Timings time_sequential_insert_h(const Options &options, int size, float non_unique)
 {
 	std::vector<T> vec = make_vector<T>(size, non_unique);
-	Timings tms{measure(mf_sequential_insertion(hms, vec))...};
+	Timings tms{measure_insertion<HashMaps>(options, vec)...};
 	return tms;
 }
-template<typename T, class... HashMaps>
-Timings time_sequential_lookups_h(int size, float non_unique, std::vector<T> &vec, HashMaps... hms)
+
+template<typename KeyType>
+TimingResults time_layout_lookups(const Options &options,
+						          Range &r,
+						          bool verbose=true)
 {
-	Timings tms{measure(mf_sequential_lookups(hms, vec))...};
-	return tms;
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		// the second half of the keys is never inserted
+		std::vector<KeyType> keys = make_vector<KeyType>(2 * size, 0.0f);
+		std::vector<KeyType> hits(keys.begin(), keys.begin() + size);
+		std::vector<KeyType> misses(keys.begin() + size, keys.end());
+		stroupo::hash_map<KeyType, int> node_hm;
+		stroupo::hash_map<KeyType, int, std::hash<KeyType>, std::equal_to<KeyType>,
+						  std::allocator<std::pair<const KeyType, int>>,
+						  stroupo::control_byte_layout> control_byte_hm;
+		for(const KeyType &k : hits)
+		{
+			node_hm.insert({k, 0});
+			control_byte_hm.insert({k, 0});
+		}
+		Timings timings{measure(options, hits.size(), timed(mf_sequential_lookups(node_hm, hits))),
+						measure(options, hits.size(), timed(mf_sequential_lookups(control_byte_hm, hits))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(node_hm, misses))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(control_byte_hm, misses)))};
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// integer keys only, the negative keys are never inserted
+template<typename KeyType>
+TimingResults time_sentinel_lookups(const Options &options,
+						            Range &r,
+						            bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(2 * size, 0.0f);
+		std::vector<KeyType> hits(keys.begin(), keys.begin() + size);
+		std::vector<KeyType> misses(keys.begin() + size, keys.end());
+		stroupo::hash_map<KeyType, KeyType> node_hm;
+		stroupo::hash_map<KeyType, KeyType, std::hash<KeyType>, std::equal_to<KeyType>,
+						  std::allocator<std::pair<const KeyType, KeyType>>,
+						  stroupo::sentinel_layout<-1, -2>> sentinel_hm;
+		for(const KeyType &k : hits)
+		{
+			node_hm.insert({k, k});
+			sentinel_hm.insert({k, k});
+		}
+		Timings timings{measure(options, hits.size(), timed(mf_sequential_lookups(node_hm, hits))),
+						measure(options, hits.size(), timed(mf_sequential_lookups(sentinel_hm, hits))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(node_hm, misses))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(sentinel_hm, misses)))};
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// Both maps use the same hasher.
+template<typename KeyType>
+TimingResults time_frozen_lookups(const Options &options,
+								  Range &r,
+								  bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(2 * size, 0.0f);
+		std::vector<KeyType> hits(keys.begin(), keys.begin() + size);
+		std::vector<KeyType> misses(keys.begin() + size, keys.end());
+		stroupo::hash_map<KeyType, KeyType, stroupo::hash<KeyType>> hm;
+		for(const KeyType &k : hits) hm.insert({k, k});
+		const stroupo::frozen_hash_map<KeyType, KeyType> frozen{hm};
+		Timings timings{measure(options, hits.size(), timed(mf_sequential_lookups(hm, hits))),
+						measure(options, hits.size(), timed(mf_sequential_lookups(frozen, hits))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(hm, misses))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(frozen, misses)))};
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// the memory of both maps in bytes per entry
+template<typename KeyType>
+TimingResults time_frozen_memory(Range &r)
+{
+	TimingResults results;
+	for(int size : range<int>(r))
+	{
+		stroupo::hash_map<KeyType, KeyType, stroupo::hash<KeyType>> hm;
+		for(const KeyType &k : make_vector<KeyType>(size, 0.0f)) hm.insert({k, k});
+		const stroupo::frozen_hash_map<KeyType, KeyType> frozen{hm};
+		results.push_back({size, {Statistics{{double(hm.memory_usage().total()) / size}},
+								  Statistics{{double(frozen.memory_usage().total()) / size}}}});
+	}
+	return results;
+}
+
+// a mapped type of the given size which is never read by lookups
+template<std::size_t Size>
+struct Payload
+{
+	char data[Size]{};
+};
+
+template<typename KeyType, std::size_t Size>
+Timings time_soa_lookups_h(const Options &options, int size)
+{
+	// the second half of the keys is never inserted
+	std::vector<KeyType> keys = make_vector<KeyType>(2 * size, 0.0f);
+	std::vector<KeyType> hits(keys.begin(), keys.begin() + size);
+	std::vector<KeyType> misses(keys.begin() + size, keys.end());
+	using Value = Payload<Size>;
+	stroupo::hash_map<KeyType, Value> node_hm;
+	stroupo::hash_map<KeyType, Value, std::hash<KeyType>, std::equal_to<KeyType>,
+					  std::allocator<std::pair<const KeyType, Value>>,
+					  stroupo::soa_layout> soa_hm;
+	for(const KeyType &k : hits)
+	{
+		node_hm.insert({k, Value{}});
+		soa_hm.insert({k, Value{}});
+	}
+	return {measure(options, hits.size(), timed(mf_sequential_lookups(node_hm, hits))),
+			measure(options, hits.size(), timed(mf_sequential_lookups(soa_hm, hits))),
+			measure(options, misses.size(), timed(mf_sequential_lookups(node_hm, misses))),
+			measure(options, misses.size(), timed(mf_sequential_lookups(soa_hm, misses)))};
+}
+
+template<typename KeyType, std::size_t Size>
+TimingResults time_soa_lookups(const Options &options,
+						       Range &r,
+						       bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		Timings timings = time_soa_lookups_h<KeyType, Size>(options, size);
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// only every 16th key is kept after all keys were inserted
+template<typename HashMap>
+Timings time_sparse_iteration_h(const Options &options,
+								HashMap &hm,
+								const std::vector<int> &keys)
+{
+	for(int k : keys) hm.insert({k, k});
+	for(int k : keys) if(k % 16 != 0) hm.erase(k);
+	Statistics iteration = measure(options, keys.size(), timed([&](){
+		long sum = 0;
+		for(const auto &e : hm) sum += e.second;
+		benchmark_sink = sum;
+	}));
+	Statistics visit = measure(options, keys.size(), timed([&](){
+		long sum = 0;
+		hm.for_each([&](int, int v){ sum += v; });
+		benchmark_sink = sum;
+	}));
+	Statistics batch = measure(options, keys.size(), timed([&](){
+		long sum = 0;
+		hm.for_each_batch([&](const int *const *, const int *const *v,
+		                      std::size_t n){
+			for(std::size_t i = 0; i < n; ++i) sum += *v[i];
+		});
+		benchmark_sink = sum;
+	}));
+	return {iteration, visit, batch};
+}
+
+TimingResults time_sparse_iteration(const Options &options,
+						            Range &r,
+						            bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		std::vector<int> keys = make_vector<int>(size, 0.0f);
+		stroupo::hash_map<int, int> node_hm;
+		stroupo::hash_map<int, int, std::hash<int>, std::equal_to<int>,
+						  std::allocator<std::pair<const int, int>>,
+						  stroupo::bitmap_layout<>> bitmap_hm;
+		Timings timings = time_sparse_iteration_h(options, node_hm, keys);
+		Timings bitmap_timings = time_sparse_iteration_h(options, bitmap_hm, keys);
+		timings.insert(timings.end(), bitmap_timings.begin(), bitmap_timings.end());
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// the time to hash all keys and the time to insert and look them up
+template<typename Hash, typename KeyType>
+Timings time_hash_function_h(const Options &options,
+							 const std::vector<KeyType> &keys)
+{
+	Statistics hashing = measure(options, keys.size(), timed([&](){
+		std::size_t sum = 0;
+		for(const KeyType &k : keys) sum += Hash{}(k);
+		benchmark_sink = sum;
+	}));
+	Statistics map = measure(options, keys.size(), [&](Timer &timer){
+		stroupo::hash_map<KeyType, int, Hash> hm;
+		std::size_t found = 0;
+		timer.start();
+		for(const KeyType &k : keys) hm.insert({k, 0});
+		for(const KeyType &k : keys) found += hm.find(k) != hm.end();
+		timer.stop();
+		benchmark_sink = found;
+	});
+	return {hashing, map};
+}
+
+// every int key is multiplied with the stride
+template<typename KeyType, typename... Hashes>
+TimingResults time_hash_functions(const Options &options,
+								  Range &r,
+								  int stride = 1,
+						          bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		if constexpr(std::is_same_v<KeyType, int>)
+			for(int &k : keys) k *= stride;
+		Timings timings;
+		for(const Timings &t : {time_hash_function_h<Hashes>(options, keys)...})
+			timings.insert(timings.end(), t.begin(), t.end());
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
 }
+
 template<typename KeyType>
-TimingResults time_sequential_insert(Range &r,
-							         float unique,
-						             bool verbose=true)
+TimingResults time_probing_lookups(const Options &options,
+						           Range &r,
+						           bool verbose=true)
 {
 	std::vector<int> sizes = range<int>(r);
 	TimingResults timing_results;
 	for(int size : sizes)
 	{
-		// std::unordered_map<KeyType, int, std::hash<KeyType>> stl_hm;
-		stroupo::hash_map<KeyType, int> stroupo_hm;
-		std::unordered_map<KeyType, int> stl_hm;
-		boost::unordered_map<KeyType, int> boost_hm;
-		// boost::unordered_map<KeyType, int, std::hash<KeyType>> boost_hm;
-		Timings timings = time_sequential_insert_h<KeyType>(size, unique,
-											                boost_hm,
-											 				stl_hm,
-											 				stroupo_hm
-											 				);
+		// the second half of the keys is never inserted
+		std::vector<KeyType> keys = make_vector<KeyType>(2 * size, 0.0f);
+		std::vector<KeyType> hits(keys.begin(), keys.begin() + size);
+		std::vector<KeyType> misses(keys.begin() + size, keys.end());
+		stroupo::hash_map<KeyType, int> linear_hm;
+		stroupo::hash_map<KeyType, int, std::hash<KeyType>, std::equal_to<KeyType>,
+						  std::allocator<std::pair<const KeyType, int>>,
+						  stroupo::robin_hood_probing> robin_hood_hm;
+		linear_hm.max_load_factor(0.9);
+		robin_hood_hm.max_load_factor(0.9);
+		for(const KeyType &k : hits)
+		{
+			linear_hm.insert({k, 0});
+			robin_hood_hm.insert({k, 0});
+		}
+		Timings timings{measure(options, hits.size(), timed(mf_sequential_lookups(linear_hm, hits))),
+						measure(options, hits.size(), timed(mf_sequential_lookups(robin_hood_hm, hits))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(linear_hm, misses))),
+						measure(options, misses.size(), timed(mf_sequential_lookups(robin_hood_hm, misses)))};
 		if(verbose)
 		{
-			std::cout << size;
-			for(auto t : timings) std::cout << "\t" << t;
-			std::cout << "\n";
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
 		}
 		timing_results.push_back({size, timings});
 	}
 	return timing_results;
 }
+
+// the tables should be far larger than the last level cache
 template<typename KeyType>
-TimingResults time_sequential_lookups(Range &r,
-						   float unique,
-						   bool verbose=true)
+TimingResults time_batch_lookups(const Options &options,
+						         Range &r,
+						         bool verbose=true)
 {
 	std::vector<int> sizes = range<int>(r);
 	TimingResults timing_results;
 	for(int size : sizes)
 	{
-		std::vector<KeyType> keys = make_vector<KeyType>(size, unique);
-		std::unordered_map<KeyType, int> stl_hm;
-		boost::unordered_map<KeyType, int> boost_hm;
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		std::vector<char> found(keys.size());
+		stroupo::hash_map<KeyType, int> node_hm;
+		stroupo::hash_map<KeyType, int, std::hash<KeyType>, std::equal_to<KeyType>,
+						  std::allocator<std::pair<const KeyType, int>>,
+						  stroupo::control_byte_layout> control_byte_hm;
+		node_hm.reserve(size);
+		control_byte_hm.reserve(size);
 		for(const KeyType &k : keys)
 		{
-			boost_hm.insert({k, 0});
-			stl_hm.insert({k, 0});
+			node_hm.insert({k, 0});
+			control_byte_hm.insert({k, 0});
 		}
-		Timings timings = time_sequential_lookups_h<KeyType>(size, unique, keys,
-											 	             boost_hm,
-											 	             stl_hm);
+		// lookups in another order than the insertions
+		std::shuffle(keys.begin(), keys.end(), std::mt19937{std::random_device{}()});
+		Timings timings{measure(options, keys.size(), timed(mf_single_contains(node_hm, keys, found))),
+						measure(options, keys.size(), timed(mf_batch_contains(node_hm, keys, found))),
+						measure(options, keys.size(), timed(mf_single_contains(control_byte_hm, keys, found))),
+						measure(options, keys.size(), timed(mf_batch_contains(control_byte_hm, keys, found)))};
 		if(verbose)
 		{
-			std::cout << size;
-			for(auto t : timings) std::cout << "\t" << t;
-			std::cout << "\n";
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
 		}
 		timing_results.push_back({size, timings});
 	}
 	return timing_results;
 }
 
-std::string toPylist(TimingResults &trs)
+template<typename KeyType, typename Reduction>
+using reduction_hash_map = stroupo::hash_map<KeyType, int, std::hash<KeyType>,
+											 std::equal_to<KeyType>,
+											 std::allocator<std::pair<const KeyType, int>>,
+											 Reduction>;
+// fastrange needs hashes with well distributed high bits, e.g. std::hash<std::string>
+template<typename KeyType>
+TimingResults time_reduction_insertions(const Options &options,
+								        Range &r,
+								        bool verbose=true)
 {
-	std::string str = "[";
-	for(auto tr: trs)
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
 	{
-		str.append("[");
-		str.append(std::to_string(tr.first));
-		for(auto r : tr.second)
+		Timings timings = time_sequential_insert_h<
+			KeyType,
+			reduction_hash_map<KeyType, stroupo::modulo_reduction>,
+			reduction_hash_map<KeyType, stroupo::power_of_two_reduction>,
+			reduction_hash_map<KeyType, stroupo::fibonacci_reduction>,
+			reduction_hash_map<KeyType, stroupo::fastrange_reduction>>(options, size, 0.0f);
+		if(verbose)
 		{
-			str.append(",");
-			str.append(std::to_string(r));
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
 		}
-		str.append("],\n");
-	}
-	str.append("]");
-	return str;
-}
-std::string trToPython(TimingResults &trs,
-				std::string title,
-				std::string filename,
-				std::vector<std::string> names,
-				std::string xlabel="input size",
-				std::string ylabel="time / s")
-{
-	std::string code;
-	code.append("import matplotlib.pyplot as plt\n");
-	code.append("xys=" + toPylist(trs) + "\n");
-	code.append("title='" + title +"'\n");
-	code.append("filename='" + filename + "'\n");
-	code.append("names=[");
-	for(auto name : names) code.append("'" + name + "'," );
-	code.append("]\n");
-	code.append("xlabel='"+xlabel+"'\n");
-	code.append("ylabel='"+ylabel+"'\n");
-	code.append("xys = list(map(list, zip(*xys)))\n");
-	code.append("xs = xys[0]\n");
-	code.append("for ys, name in zip(xys[1:], names):\n");
-	code.append("\tplt.plot(xs, ys, label=name)\n");
-	code.append("plt.xlabel(xlabel)\n");
-	code.append("plt.ylabel(ylabel)\n");
-	code.append("plt.title(title)\n");
-	code.append("plt.legend()\n");
-	code.append("plt.savefig(filename)\n");
-	code = "\"" + code + "\""; 
-	return code;
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
 }
 
+template<typename KeyType, typename... Policies>
+using policy_hash_map = stroupo::hash_map<KeyType, int, std::hash<KeyType>,
+										  std::equal_to<KeyType>,
+										  std::allocator<std::pair<const KeyType, int>>,
+										  Policies...>;
+// growth is dominated by rehashing, hence the tables are not reserved
 template<typename KeyType>
-void benchmark_all_sequential_insertions(Range &r, std::string keytype, float unique, std::string filename)
+TimingResults time_hash_storage(const Options &options,
+						        Range &r,
+						        bool verbose=true)
 {
-	TimingResults trs = time_sequential_insert<KeyType>(r, unique);
-	MakeUniqueString mus;
-	std::string code = trToPython(
-		trs,
-		"Sequential Inserts - Unique: "+ std::to_string(unique)  +"  - " + keytype,
-		img_path +  "/"+ filename,
-		{"BOOST", "STL", "STROUPO"});
-	std::system(("python -c " + code).c_str());
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		using recomputed_map = policy_hash_map<KeyType, stroupo::recomputed_hash>;
+		using stored_map = policy_hash_map<KeyType, stroupo::stored_hash>;
+		Timings timings{measure_insertion<recomputed_map>(options, keys),
+						measure_insertion<stored_map>(options, keys)};
+		recomputed_map recomputed_hm;
+		stored_map stored_hm;
+		mf_sequential_insertion(recomputed_hm, keys)();
+		mf_sequential_insertion(stored_hm, keys)();
+		std::vector<char> found(keys.size());
+		timings.push_back(measure(options, keys.size(), timed(mf_single_contains(recomputed_hm, keys, found))));
+		timings.push_back(measure(options, keys.size(), timed(mf_single_contains(stored_hm, keys, found))));
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// Latencies of single insertions in microseconds at the given quantiles. Every
+// repetition inserts into a new map, and the quantiles are summarized over
+// the repetitions.
+template<typename HashMap, typename T>
+Timings insert_latencies(const Options &options,
+						 std::vector<T> &vec,
+						 const std::vector<double> &quantiles)
+{
+	std::vector<std::vector<Time>> samples(quantiles.size());
+	std::vector<Time> latencies(vec.size());
+	for(int repetition = 0; repetition < options.warmup + options.repetitions; ++repetition)
+	{
+		HashMap hm;
+		for(std::size_t i = 0; i < vec.size(); ++i)
+		{
+			auto begin = std::chrono::high_resolution_clock::now();
+			hm.insert({vec[i], 0});
+			auto end = std::chrono::high_resolution_clock::now();
+			latencies[i] = std::chrono::duration<Time, std::micro>(end - begin).count();
+		}
+		benchmark_sink = hm.size();
+		if(repetition < options.warmup) continue;
+		std::sort(latencies.begin(), latencies.end());
+		for(std::size_t i = 0; i < quantiles.size(); ++i)
+			samples[i].push_back(latencies[std::min(latencies.size() - 1,
+													std::size_t(quantiles[i] * latencies.size()))]);
+	}
+	Timings result;
+	for(auto &s : samples) result.push_back(Statistics{s});
+	return result;
 }
+
+// the full rehash moves every entry within one insertion which dominates the tail
 template<typename KeyType>
-void benchmark_all_sequential_lookups(Range &r, std::string keytype, float unique, std::string filename)
+TimingResults time_insert_latencies(const Options &options,
+									Range &r,
+									bool verbose=true)
 {
-	TimingResults trs = time_sequential_lookups<KeyType>(r, unique);
-	MakeUniqueString mus;
-	std::string code = trToPython(
-		trs,
-		"Sequential Lookups - Unique: "+ std::to_string(unique)  +"  - " + keytype,
-		img_path +  "/"+ filename,
-		{"BOOST", "STL", "STROUPO"});
-	std::system(("python -c " + code).c_str());
-}
-
-int main()
-{
-	Range r{60'000, 200'000, 20'000};
-	benchmark_all_sequential_insertions<std::string>(r, "str", 0.0f, "inserts-unique-str");
-	benchmark_all_sequential_insertions<std::string>(r, "str", 0.5f, "inserts-non-unique-str");
-	benchmark_all_sequential_insertions<int>(r, "int", 0.0f, "inserts-unique-int");
-	benchmark_all_sequential_insertions<int>(r, "int", 0.5f, "inserts-non-unique-int");
-	benchmark_all_sequential_lookups<std::string>(r, "str", 0.0f, "lookups-unique-str");
-	benchmark_all_sequential_lookups<std::string>(r, "str", 0.5f, "lookups-non-unique-str");
-	benchmark_all_sequential_lookups<int>(r, "int", 0.0f, "lookups-unique-int");
-	benchmark_all_sequential_lookups<int>(r, "int", 0.5f, "lookups-non-unique-int");
-}
\ No newline at end of file
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	const std::vector<double> quantiles{0.99, 0.999, 1.0};
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		Timings full = insert_latencies<policy_hash_map<KeyType, stroupo::full_rehash>>(
+			options, keys, quantiles);
+		Timings incremental = insert_latencies<
+			policy_hash_map<KeyType, stroupo::incremental_rehash<>>>(options, keys, quantiles);
+		Timings timings;
+		for(std::size_t i = 0; i < quantiles.size(); ++i)
+		{
+			timings.push_back(full[i]);
+			timings.push_back(incremental[i]);
+		}
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// the parallel versions use one thread per hardware thread
+template<typename KeyType>
+TimingResults time_parallel_build(const Options &options,
+								  Range &r,
+								  bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		std::vector<std::pair<KeyType, int>> values;
+		for(auto &k : keys) values.push_back({k, 0});
+		Timings timings{measure(options, values.size(), [&](Timer &timer){
+			policy_hash_map<KeyType> hm;
+			timer.start();
+			hm.reserve(values.size());
+			hm.insert(values.begin(), values.end());
+			timer.stop();
+			benchmark_sink = hm.size();
+		})};
+		timings.push_back(measure(options, values.size(), [&](Timer &timer){
+			timer.start();
+			auto hm = policy_hash_map<KeyType>::build_from(values.begin(), values.end());
+			timer.stop();
+			benchmark_sink = hm.size();
+		}));
+		// every repetition rehashes a copy of the same table
+		const auto built_hm = policy_hash_map<KeyType>::build_from(values.begin(), values.end());
+		timings.push_back(measure(options, values.size(), [&](Timer &timer){
+			policy_hash_map<KeyType> hm = built_hm;
+			timer.start();
+			hm.rehash(2 * hm.capacity());
+			timer.stop();
+			benchmark_sink = hm.capacity();
+		}));
+		timings.push_back(measure(options, values.size(), [&](Timer &timer){
+			policy_hash_map<KeyType> hm = built_hm;
+			timer.start();
+			hm.rehash(2 * hm.capacity(), stroupo::execution::par);
+			timer.stop();
+			benchmark_sink = hm.capacity();
+		}));
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// a restart either reinserts every key or only maps the file of the table
+template<typename KeyType>
+TimingResults time_persistent_startup(const Options &options,
+									  Range &r,
+									  bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	std::string path = (boost::filesystem::temp_directory_path() /
+						boost::filesystem::unique_path()).string();
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		{
+			stroupo::mapped_hash_map<KeyType, int> mapped_hm{path};
+			mapped_hm.reserve(keys.size());
+			for(auto &k : keys) mapped_hm.insert(k, 0);
+		}
+		Timings timings{measure(options, keys.size(), timed([&](){
+			policy_hash_map<KeyType> hm;
+			for(auto &k : keys) hm.insert({k, 0});
+			benchmark_sink = hm.contains(keys.front());
+		}))};
+		timings.push_back(measure(options, keys.size(), timed([&](){
+			stroupo::mapped_hash_map<KeyType, int> mapped_hm{path};
+			benchmark_sink = mapped_hm.contains(keys.front());
+		})));
+		boost::filesystem::remove(path);
+		if(verbose)
+		{
+			std::cerr << size;
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+// throughput in GB/s of snapshots and of writing and reinserting every entry,
+// the files are usually served by the page cache
+template<typename KeyType>
+TimingResults time_snapshots(const Options &options,
+							 Range &r,
+							 bool verbose=true)
+{
+	std::vector<int> sizes = range<int>(r);
+	TimingResults timing_results;
+	std::string path = (boost::filesystem::temp_directory_path() /
+						boost::filesystem::unique_path()).string();
+	for(int size : sizes)
+	{
+		std::vector<KeyType> keys = make_vector<KeyType>(size, 0.0f);
+		policy_hash_map<KeyType> hm;
+		for(auto &k : keys) hm.insert({k, 0});
+
+		Statistics save = measure(options, 1, timed([&](){
+			std::ofstream out(path, std::ios::binary);
+			hm.save(out);
+		}));
+		policy_hash_map<KeyType> loaded_hm;
+		Statistics load = measure(options, 1, timed([&](){
+			std::ifstream in(path, std::ios::binary);
+			loaded_hm.load(in);
+		}));
+		const double bytes = boost::filesystem::file_size(path);
+
+		Statistics naive_save = measure(options, 1, timed([&](){
+			std::ofstream out(path, std::ios::binary);
+			for(auto &entry : hm)
+			{
+				out.write(reinterpret_cast<const char*>(&entry.first), sizeof(entry.first));
+				out.write(reinterpret_cast<const char*>(&entry.second), sizeof(entry.second));
+			}
+		}));
+		std::size_t naive_size = 0;
+		Statistics naive_load = measure(options, 1, [&](Timer &timer){
+			policy_hash_map<KeyType> naive_hm;
+			timer.start();
+			std::ifstream in(path, std::ios::binary);
+			std::pair<KeyType, int> entry;
+			while(in.read(reinterpret_cast<char*>(&entry.first), sizeof(entry.first)) &&
+				  in.read(reinterpret_cast<char*>(&entry.second), sizeof(entry.second)))
+				naive_hm.insert(entry);
+			timer.stop();
+			naive_size = naive_hm.size();
+		});
+		const double naive_bytes = boost::filesystem::file_size(path);
+		boost::filesystem::remove(path);
+
+		Timings timings{throughput(save, bytes), throughput(load, bytes),
+						throughput(naive_save, naive_bytes), throughput(naive_load, naive_bytes)};
+		if(verbose)
+		{
+			std::cerr << size << "\t" << (loaded_hm.size() == naive_size);
+			for(auto t : timings) std::cerr << "\t" << t.median;
+			std::cerr << "\n";
+		}
+		timing_results.push_back({size, timings});
+	}
+	return timing_results;
+}
+
+
+// the core suite, which compares the maps at the same operations
+template<typename HashMap, typename KeyType>
+void time_core_operations(Report &report,
+						  const Options &options,
+						  const std::string &map,
+						  const std::string &key,
+						  std::vector<KeyType> &hits,
+						  std::vector<KeyType> &misses)
+{
+	const std::size_t size = hits.size();
+	auto run = [&](const std::string &operation, auto function){
+		if(!selected(options, "core/" + operation)) return;
+		report.add({"core", operation, map, key, size, "ns/op",
+					measure(options, size, function)});
+	};
+	HashMap filled;
+	for(const KeyType &k : hits) filled.insert({k, 0});
+	std::vector<KeyType> shuffled = hits;
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{42});
+
+	run("insert", [&](Timer &timer){
+		HashMap hm;
+		timer.start();
+		mf_sequential_insertion(hm, hits)();
+		timer.stop();
+		benchmark_sink = hm.size();
+	});
+	run("lookup-hit", [&](Timer &timer){
+		std::size_t found = 0;
+		timer.start();
+		for(const KeyType &k : shuffled) found += filled.find(k) != filled.end();
+		timer.stop();
+		benchmark_sink = found;
+	});
+	run("lookup-miss", [&](Timer &timer){
+		std::size_t found = 0;
+		timer.start();
+		for(const KeyType &k : misses) found += filled.find(k) != filled.end();
+		timer.stop();
+		benchmark_sink = found;
+	});
+	run("erase", [&](Timer &timer){
+		HashMap hm{filled};
+		timer.start();
+		mf_sequential_erasures(hm, shuffled)();
+		timer.stop();
+		benchmark_sink = hm.size();
+	});
+	run("insert-erase", [&](Timer &timer){
+		HashMap hm;
+		timer.start();
+		mf_mixed_insert_erase(hm, hits)();
+		timer.stop();
+		benchmark_sink = hm.size();
+	});
+	run("iteration", [&](Timer &timer){
+		std::size_t sum = 0;
+		timer.start();
+		for(const auto &e : filled) sum += e.second + 1;
+		timer.stop();
+		benchmark_sink = sum;
+	});
+	run("copy", [&](Timer &timer){
+		timer.start();
+		HashMap hm{filled};
+		timer.stop();
+		benchmark_sink = hm.size();
+	});
+}
+
+template<typename KeyType>
+void benchmark_core_operations(Report &report, const Options &options, std::string keytype)
+{
+	const std::vector<int> sizes = options.quick ?
+		std::vector<int>{100'000} : std::vector<int>{100'000, 1'000'000};
+	for(int size : sizes)
+	{
+		// the second half of the keys is never inserted
+		std::vector<KeyType> keys = make_unique_vector<KeyType>(2 * size);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937{42});
+		std::vector<KeyType> hits(keys.begin(), keys.begin() + size);
+		std::vector<KeyType> misses(keys.begin() + size, keys.end());
+		time_core_operations<stroupo::hash_map<KeyType, int>>(
+			report, options, "stroupo", keytype, hits, misses);
+		time_core_operations<std::unordered_map<KeyType, int>>(
+			report, options, "std", keytype, hits, misses);
+		time_core_operations<boost::unordered_map<KeyType, int>>(
+			report, options, "boost", keytype, hits, misses);
+	}
+}
+
+// returns the number of operations which found their key
+template<typename HashMap, typename KeyType>
+std::size_t replay(HashMap &hm, const std::vector<KeyType> &keys, const Workload &w)
+{
+	std::size_t found = 0;
+	for(const auto &operation : w.operations)
+	{
+		const KeyType &key = keys[operation.second];
+		switch(operation.first)
+		{
+			case Op::insert: hm.insert({key, 0}); break;
+			case Op::lookup: found += hm.find(key) != hm.end(); break;
+			case Op::erase: found += hm.erase(key); break;
+			case Op::update: ++hm[key]; break;
+		}
+	}
+	return found;
+}
+
+template<typename HashMap, typename KeyType>
+void time_workload(Report &report,
+				   const Options &options,
+				   const std::string &map,
+				   const std::string &keytype,
+				   const std::vector<KeyType> &keys,
+				   const Workload &w)
+{
+	HashMap preloaded;
+	for(std::size_t i = 0; i < w.preload; ++i) preloaded.insert({keys[i], 0});
+	report.add({"workloads", w.name, map, keytype, w.key_count, "ns/op",
+				measure(options, w.operations.size(), [&](Timer &timer){
+		HashMap hm{preloaded};
+		timer.start();
+		const std::size_t found = replay(hm, keys, w);
+		timer.stop();
+		benchmark_sink = found;
+	})});
+}
+
+template<typename KeyType>
+void time_workload_all(Report &report,
+					   const Options &options,
+					   const std::string &keytype,
+					   const std::vector<KeyType> &keys,
+					   const Workload &w)
+{
+	if(!selected(options, "workloads/" + w.name)) return;
+	time_workload<stroupo::hash_map<KeyType, int>>(report, options, "stroupo", keytype, keys, w);
+	time_workload<std::unordered_map<KeyType, int>>(report, options, "std", keytype, keys, w);
+	time_workload<boost::unordered_map<KeyType, int>>(report, options, "boost", keytype, keys, w);
+}
+
+template<typename KeyType>
+void benchmark_workloads(Report &report, const Options &options, std::string keytype)
+{
+	const std::size_t records = options.quick ? 100'000 : 1'000'000;
+	const std::size_t operations = 2 * records;
+	std::vector<Workload> workloads;
+	for(double theta : {0.5, 0.99})
+		workloads.push_back(zipf_workload(records, operations, theta));
+	workloads.push_back(churn_workload(records, operations / 3));
+	for(char type : {'A', 'B', 'C', 'D'})
+		workloads.push_back(ycsb_workload(type, records, operations));
+	std::size_t key_count = 0;
+	for(const Workload &w : workloads) key_count = std::max(key_count, w.key_count);
+	// Sequential integers would form a single cluster under std::hash, which
+	// makes every erasure of linear probing scan the whole window.
+	std::vector<KeyType> keys = make_unique_vector<KeyType>(key_count);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937{42});
+	for(const Workload &w : workloads) time_workload_all(report, options, keytype, keys, w);
+}
+
+template<typename HashMap, typename = void>
+struct HasMemoryUsage : std::false_type {};
+template<typename HashMap>
+struct HasMemoryUsage<HashMap, std::void_t<decltype(std::declval<const HashMap &>().memory_usage())>>
+	: std::true_type {};
+
+// The memory of the keys themselves, like the heap buffers of long strings,
+// is not counted by the allocator. stroupo reports it by memory_usage.
+template<typename HashMap, typename KeyType>
+void time_memory(Report &report,
+				 const std::string &map,
+				 const std::string &keytype,
+				 const std::vector<KeyType> &keys,
+				 float max_load_factor)
+{
+	const std::size_t size = keys.size();
+	const std::string lf = "-lf" + std::to_string(max_load_factor).substr(0, 4);
+	auto add = [&](const std::string &operation, const std::string &unit, double value){
+		report.add({"memory", operation + lf, map, keytype, size, unit, Statistics{{value}}});
+	};
+	allocation_counter = {};
+	HashMap hm;
+	hm.max_load_factor(max_load_factor);
+	for(const KeyType &k : keys) hm.insert({k, 0});
+	add("peak", "B/entry", double(allocation_counter.peak) / size);
+	add("steady", "B/entry", double(allocation_counter.current) / size);
+	add("allocations", "allocs", allocation_counter.allocations);
+	if constexpr(HasMemoryUsage<HashMap>::value)
+	{
+		const stroupo::hash_map_memory memory = hm.memory_usage();
+		add("table", "B/entry", double(memory.table_bytes) / size);
+		add("padding", "B/entry", double(memory.padding_bytes) / size);
+		add("key-heap", "B/entry", double(memory.key_heap_bytes) / size);
+	}
+}
+
+template<typename KeyType>
+void benchmark_memory(Report &report, const Options &options, std::string keytype)
+{
+	using Allocator = CountingAllocator<std::pair<const KeyType, int>>;
+	const std::vector<int> sizes = options.quick ?
+		std::vector<int>{100'000} : std::vector<int>{100'000, 1'000'000, 4'000'000};
+	for(int size : sizes)
+	{
+		const std::vector<KeyType> keys = make_vector<KeyType>(size);
+		for(float max_load_factor : {0.5f, 0.75f, 0.9f})
+		{
+			time_memory<stroupo::hash_map<KeyType, int, std::hash<KeyType>,
+										  std::equal_to<KeyType>, Allocator>>(
+				report, "stroupo", keytype, keys, max_load_factor);
+			time_memory<std::unordered_map<KeyType, int, std::hash<KeyType>,
+										   std::equal_to<KeyType>, Allocator>>(
+				report, "std", keytype, keys, max_load_factor);
+			time_memory<boost::unordered_map<KeyType, int, std::hash<KeyType>,
+											 std::equal_to<KeyType>, Allocator>>(
+				report, "boost", keytype, keys, max_load_factor);
+		}
+	}
+}
+
+// adds the results of an experiment, one record per size and measurement
+void report_experiment(Report &report,
+					   const std::string &suite,
+					   const std::string &keytype,
+					   const TimingResults &trs,
+					   const std::vector<std::string> &names,
+					   const std::string &unit="ns/op")
+{
+	for(const auto &tr : trs)
+	{
+		for(std::size_t i = 0; i < names.size(); ++i)
+		{
+			report.add({suite, names[i], "stroupo", keytype,
+						static_cast<std::size_t>(tr.first), unit, tr.second[i]});
+		}
+	}
+}
+
+void benchmark_experiments(Report &report, const Options &options)
+{
+	Range r = options.quick ? Range{20'000, 40'001, 20'000} : Range{60'000, 200'000, 20'000};
+	Range large = options.quick ? Range{250'000, 500'001, 250'000}
+								: Range{2'500'000, 12'500'001, 2'500'000};
+	auto run = [&](const std::string &suite, const std::string &keytype,
+				   auto time, const std::vector<std::string> &names,
+				   const std::string &unit="ns/op"){
+		if(!selected(options, suite)) return;
+		report_experiment(report, suite, keytype, time(), names, unit);
+	};
+	const std::vector<std::string> hit_miss{"node-hit", "control-byte-hit", "node-miss", "control-byte-miss"};
+	run("layout-lookups", "str", [&]{ return time_layout_lookups<std::string>(options, r); }, hit_miss);
+	run("layout-lookups", "int", [&]{ return time_layout_lookups<int>(options, r); }, hit_miss);
+	const std::vector<std::string> soa{"node-hit", "soa-hit", "node-miss", "soa-miss"};
+	run("soa-lookups-64", "int", [&]{ return time_soa_lookups<int, 64>(options, r); }, soa);
+	run("soa-lookups-256", "int", [&]{ return time_soa_lookups<int, 256>(options, r); }, soa);
+	const std::vector<std::string> probing{"linear-hit", "robin-hood-hit", "linear-miss", "robin-hood-miss"};
+	run("probing-lookups", "str", [&]{ return time_probing_lookups<std::string>(options, r); }, probing);
+	run("probing-lookups", "int", [&]{ return time_probing_lookups<int>(options, r); }, probing);
+	run("reduction-inserts", "str", [&]{ return time_reduction_insertions<std::string>(options, r); },
+		{"modulo", "power-of-two", "fibonacci", "fastrange"});
+	run("hash-storage", "str", [&]{ return time_hash_storage<std::string>(options, r); },
+		{"recomputed-insert", "stored-insert", "recomputed-lookup", "stored-lookup"});
+	const std::vector<std::string> int_hashes{
+		"std-hashing", "std-map", "murmur-hashing", "murmur-map",
+		"multiply-xorshift-hashing", "multiply-xorshift-map",
+		"crc32c-hashing", "crc32c-map"};
+	for(int stride : {1, 1024})
+	{
+		run("hash-functions-stride-" + std::to_string(stride), "int", [&]{
+			return time_hash_functions<int, std::hash<int>, stroupo::murmur_hash,
+				stroupo::multiply_xorshift_hash, stroupo::crc32c_hash>(options, r, stride);
+		}, int_hashes);
+	}
+	run("hash-functions", "str", [&]{
+		return time_hash_functions<std::string, std::hash<std::string>,
+			stroupo::wyhash, stroupo::crc32c_hash>(options, r);
+	}, {"std-hashing", "std-map", "wyhash-hashing", "wyhash-map",
+		"crc32c-hashing", "crc32c-map"});
+	run("insert-latencies", "int", [&]{ return time_insert_latencies<int>(options, r); },
+		{"full-p99", "incremental-p99", "full-p99.9", "incremental-p99.9",
+		 "full-max", "incremental-max"}, "us");
+	run("batch-lookups", "int", [&]{ return time_batch_lookups<int>(options, large); },
+		{"node-single", "node-batch", "control-byte-single", "control-byte-batch"});
+	run("sentinel-lookups", "int", [&]{ return time_sentinel_lookups<int>(options, large); },
+		{"node-hit", "sentinel-hit", "node-miss", "sentinel-miss"});
+	run("frozen-lookups", "int", [&]{ return time_frozen_lookups<int>(options, large); },
+		{"hash-map-hit", "frozen-hit", "hash-map-miss", "frozen-miss"});
+	run("frozen-memory", "int", [&]{ return time_frozen_memory<int>(large); },
+		{"hash-map", "frozen"}, "B/entry");
+	run("sparse-iteration", "int", [&]{ return time_sparse_iteration(options, large); },
+		{"node-iterator", "node-for-each", "node-batch",
+		 "bitmap-iterator", "bitmap-for-each", "bitmap-batch"});
+	run("parallel-build", "int", [&]{ return time_parallel_build<int>(options, large); },
+		{"serial-build", "parallel-build", "serial-rehash", "parallel-rehash"});
+	run("persistent-startup", "int", [&]{ return time_persistent_startup<int>(options, large); },
+		{"reinsert", "mapped"});
+	run("snapshots", "int", [&]{ return time_snapshots<int>(options, large); },
+		{"save", "load", "naive-save", "naive-load"}, "GB/s");
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if(!parse_options(argc, argv, options)) return 2;
+	std::ifstream baseline;
+	if(!options.check.empty())
+	{
+		baseline.open(options.check);
+		if(!baseline)
+		{
+			// the exit code makes CTest skip the check
+			std::cerr << "no baseline at " << options.check << "\n";
+			return 77;
+		}
+	}
+	Report report;
+	if(options.suite == "all" || options.suite == "core")
+	{
+		benchmark_core_operations<int>(report, options, "int");
+		benchmark_core_operations<std::string>(report, options, "str");
+	}
+	if(options.suite == "all" || options.suite == "workloads")
+	{
+		benchmark_workloads<int>(report, options, "int");
+		benchmark_workloads<std::string>(report, options, "str");
+		if(!options.trace.empty())
+		{
+			std::vector<std::string> keys;
+			const Workload trace = trace_workload(options.trace, keys);
+			time_workload_all(report, options, "str", keys, trace);
+		}
+	}
+	if((options.suite == "all" || options.suite == "memory") && selected(options, "memory"))
+	{
+		benchmark_memory<int>(report, options, "int");
+		benchmark_memory<std::string>(report, options, "str");
+	}
+	if(options.suite == "all" || options.suite == "experiments")
+		benchmark_experiments(report, options);
+
+	if(options.output.empty())
+	{
+		report.write(std::cout, options.format);
+	}
+	else
+	{
+		std::ofstream file{options.output};
+		report.write(file, options.format);
+	}
+
+	if(options.check.empty()) return 0;
+	return check_regressions(report, baseline, options.threshold, std::cout) ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/*
+Throughput of concurrent reads and writes for a varying number of threads.
+Compares a hash_map behind one global mutex with the sharded
+concurrent_hash_map. Every thread runs the same number of operations on
+uniformly distributed keys. A fixed fraction of them are lookups, the rest
+are insertions.
+The second table shows the read throughput of the RCU hash map. All threads
+only read while one additional writer periodically changes the map.
+*/
+
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<cstdint>
+#include<iostream>
+#include<mutex>
+#include<random>
+#include<string>
+#include<thread>
+#include<vector>
+#include <hash_map/concurrent_hash_map.h>
+#include <hash_map/hash_map.h>
+#include <hash_map/rcu_hash_map.h>
+
+
+typedef double Time;
+
+constexpr int key_count = 1 << 20;
+constexpr int operations_per_thread = 1 << 20;
+
+// the naive approach which does not scale
+struct LockedHashMap
+{
+	bool find(int key)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		return hm.find(key) != hm.end();
+	}
+	void insert(int key, int value)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		hm.insert({key, value});
+	}
+	std::mutex mutex;
+	stroupo::hash_map<int, int> hm;
+};
+
+struct ShardedHashMap
+{
+	bool find(int key)
+	{
+		return hm.find(key, [](int){});
+	}
+	void insert(int key, int value)
+	{
+		hm.insert({key, value});
+	}
+	stroupo::concurrent_hash_map<int, int> hm;
+};
+
+struct RcuHashMap
+{
+	bool find(int key)
+	{
+		return hm.find(key, [](int){});
+	}
+	void insert(int key, int value)
+	{
+		hm.insert({key, value});
+	}
+	stroupo::rcu_hash_map<int, int> hm;
+};
+
+template<typename HashMap>
+void prefill(HashMap &map)
+{
+	for(int key = 0; key < key_count; key += 2) map.insert(key, key);
+}
+// every insertion into the RCU hash map copies it, hence it is built at once
+void prefill(RcuHashMap &map)
+{
+	stroupo::hash_map<int, int> hm;
+	for(int key = 0; key < key_count; key += 2) hm.insert({key, key});
+	map.hm.publish(std::move(hm));
+}
+
+// returns the throughput in million operations per second
+template<typename HashMap>
+double measure_throughput(HashMap &map, int threads, double read_ratio)
+{
+	std::atomic<bool> start{false};
+	std::atomic<std::uint64_t> hits{0};
+	std::vector<std::thread> workers;
+	for(int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&, t](){
+			std::mt19937 rng(t);
+			std::uniform_int_distribution<int> key_dist{0, key_count - 1};
+			std::bernoulli_distribution read_dist{read_ratio};
+			std::uint64_t local_hits = 0;
+			while(!start) std::this_thread::yield();
+			for(int i = 0; i < operations_per_thread; ++i)
+			{
+				const int key = key_dist(rng);
+				if(read_dist(rng)) local_hits += map.find(key);
+				else map.insert(key, i);
+			}
+			hits += local_hits;
+		});
+	}
+	auto begin = std::chrono::high_resolution_clock::now();
+	start = true;
+	for(auto &worker : workers) worker.join();
+	auto end = std::chrono::high_resolution_clock::now();
+	Time time = std::chrono::duration<Time>(end - begin).count();
+	return double(threads) * operations_per_thread / time / 1e6;
+}
+
+// returns the read throughput in million lookups per second
+template<typename HashMap>
+double measure_read_throughput(HashMap &map, int threads)
+{
+	std::atomic<bool> done{false};
+	std::thread writer([&](){
+		for(int i = 0; !done; ++i)
+		{
+			map.insert(2 * i + 1, i);
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	});
+	const double throughput = measure_throughput(map, threads, 1.0);
+	done = true;
+	writer.join();
+	return throughput;
+}
+
+std::vector<int> thread_counts()
+{
+	const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<int> counts;
+	for(int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+	counts.push_back(max_threads);
+	return counts;
+}
+
+int main()
+{
+	std::cout << "million operations per second\n";
+	std::cout << "reads\tthreads\tLOCKED\tSHARDED\n";
+	for(double read_ratio : {0.5, 0.9, 0.99})
+	{
+		for(int threads : thread_counts())
+		{
+			LockedHashMap locked;
+			ShardedHashMap sharded;
+			prefill(locked);
+			prefill(sharded);
+			std::cout << read_ratio << "\t" << threads
+					  << "\t" << measure_throughput(locked, threads, read_ratio)
+					  << "\t" << measure_throughput(sharded, threads, read_ratio)
+					  << "\n";
+		}
+	}
+
+	std::cout << "\nmillion lookups per second with one writer\n";
+	std::cout << "threads\tLOCKED\tSHARDED\tRCU\n";
+	for(int threads : thread_counts())
+	{
+		LockedHashMap locked;
+		ShardedHashMap sharded;
+		RcuHashMap rcu;
+		prefill(locked);
+		prefill(sharded);
+		prefill(rcu);
+		std::cout << threads
+				  << "\t" << measure_read_throughput(locked, threads)
+				  << "\t" << measure_read_throughput(sharded, threads)
+				  << "\t" << measure_read_throughput(rcu, threads)
+				  << "\n";
+	}
+}
@@ -0,0 +1,326 @@
+/*
+Measurement and reporting for the benchmarks.
+Every case is run a few times without being measured to warm up caches, the
+allocator and the branch predictors. Afterwards, it is repeated and the
+median, 99th percentile, mean and minimum of the repetitions are reported.
+Times are given in nanoseconds per operation. The results are printed as a
+table, as JSON or as CSV. A CSV file written by the benchmark can be used as
+a baseline for later runs. Those fail if a tracked result got slower than
+the baseline by more than a given threshold.
+*/
+
+#ifndef STROUPO_BENCH_HARNESS_H_
+#define STROUPO_BENCH_HARNESS_H_
+
+#include<algorithm>
+#include<chrono>
+#include<cmath>
+#include<cstddef>
+#include<fstream>
+#include<iomanip>
+#include<iostream>
+#include<map>
+#include<memory>
+#include<sstream>
+#include<string>
+#include<tuple>
+#include<vector>
+
+
+struct Options
+{
+	int warmup = 1;
+	int repetitions = 5;
+	// table, json or csv
+	std::string format = "table";
+	// the results are written to standard output if it is empty
+	std::string output;
+	// all, core, workloads, memory or experiments
+	std::string suite = "all";
+	// only cases whose name contains it are run
+	std::string filter;
+	// small inputs for quick checks
+	bool quick = false;
+	// the baseline to compare against
+	std::string check;
+	double threshold = 0.25;
+	// a recorded trace which is replayed by the workloads suite
+	std::string trace;
+};
+
+inline bool parse_options(int argc, char **argv, Options &options)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const auto eq = arg.find('=');
+		const std::string name = arg.substr(0, eq);
+		const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+		if(name == "--warmup") options.warmup = std::stoi(value);
+		else if(name == "--repetitions") options.repetitions = std::max(1, std::stoi(value));
+		else if(name == "--format") options.format = value;
+		else if(name == "--output") options.output = value;
+		else if(name == "--suite") options.suite = value;
+		else if(name == "--filter") options.filter = value;
+		else if(name == "--quick") options.quick = true;
+		else if(name == "--check") options.check = value;
+		else if(name == "--threshold") options.threshold = std::stod(value);
+		else if(name == "--trace") options.trace = value;
+		else
+		{
+			std::cerr << "usage: " << argv[0]
+					  << " [--warmup=N] [--repetitions=N]"
+					  << " [--format=table|json|csv] [--output=FILE]"
+					  << " [--suite=all|core|workloads|memory|experiments] [--filter=TEXT]"
+					  << " [--quick] [--check=BASELINE] [--threshold=FRACTION]"
+					  << " [--trace=FILE]\n";
+			return false;
+		}
+	}
+	return options.format == "table" || options.format == "json" ||
+		   options.format == "csv";
+}
+
+// whether the case or suite called name is run
+inline bool selected(const Options &options, const std::string &name)
+{
+	return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// the results of measured code are stored in it, so it cannot be optimized away
+inline volatile std::size_t benchmark_sink = 0;
+
+// Only the time between start and stop is measured. The setup of a
+// repetition, like filling a map to erase from, is not.
+class Timer
+{
+public:
+	void start() { begin = std::chrono::steady_clock::now(); }
+	void stop()
+	{
+		elapsed += std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - begin).count();
+	}
+	double seconds() const { return elapsed; }
+private:
+	std::chrono::steady_clock::time_point begin;
+	double elapsed = 0;
+};
+
+// the distribution of a measurement over its repetitions
+struct Statistics
+{
+	Statistics() = default;
+	Statistics(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		const std::size_t n = values.size();
+		samples = n;
+		median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+		// the nearest rank, which is the maximum for less than 100 repetitions
+		p99 = values[static_cast<std::size_t>(std::ceil(0.99 * n)) - 1];
+		min = values.front();
+		for(double v : values) mean += v / n;
+	}
+	std::size_t samples = 0;
+	double median = 0;
+	double p99 = 0;
+	double mean = 0;
+	double min = 0;
+};
+
+// Runs function(Timer&) options.warmup times without measuring it and
+// options.repetitions times with measuring it. The statistics are given in
+// nanoseconds per operation.
+template<typename Function>
+Statistics measure(const Options &options, std::size_t operations, Function function)
+{
+	for(int i = 0; i < options.warmup; ++i)
+	{
+		Timer timer;
+		function(timer);
+	}
+	std::vector<double> times;
+	for(int i = 0; i < options.repetitions; ++i)
+	{
+		Timer timer;
+		function(timer);
+		times.push_back(timer.seconds() * 1e9 / std::max<std::size_t>(operations, 1));
+	}
+	return Statistics{times};
+}
+
+struct Record
+{
+	std::string suite;
+	std::string operation;
+	std::string map;
+	std::string key;
+	std::size_t size;
+	// ns/op for timings, otherwise the unit of the experiment
+	std::string unit;
+	Statistics statistics;
+
+	double ops_per_sec() const
+	{
+		return unit == "ns/op" && statistics.median > 0 ? 1e9 / statistics.median : 0;
+	}
+	// identifies the result of a case across runs
+	std::tuple<std::string, std::string, std::string, std::string, std::size_t> id() const
+	{
+		return {suite, operation, map, key, size};
+	}
+};
+
+class Report
+{
+public:
+	void add(Record record)
+	{
+		if(verbose) write_table_row(std::cerr, record);
+		records.push_back(std::move(record));
+	}
+	const std::vector<Record> &results() const { return records; }
+
+	void write(std::ostream &os, const std::string &format) const
+	{
+		if(format == "json") write_json(os);
+		else if(format == "csv") write_csv(os);
+		else for(const Record &r : records) write_table_row(os, r);
+	}
+	void write_csv(std::ostream &os) const
+	{
+		os << "suite,operation,map,key,size,unit,samples,median,p99,mean,min,ops_per_sec\n";
+		os << std::setprecision(6);
+		for(const Record &r : records)
+		{
+			os << r.suite << "," << r.operation << "," << r.map << "," << r.key
+			   << "," << r.size << "," << r.unit << "," << r.statistics.samples
+			   << "," << r.statistics.median << "," << r.statistics.p99
+			   << "," << r.statistics.mean << "," << r.statistics.min
+			   << "," << r.ops_per_sec() << "\n";
+		}
+	}
+	void write_json(std::ostream &os) const
+	{
+		os << "[\n" << std::setprecision(6);
+		for(std::size_t i = 0; i < records.size(); ++i)
+		{
+			const Record &r = records[i];
+			os << "  {\"suite\": \"" << r.suite << "\", \"operation\": \"" << r.operation
+			   << "\", \"map\": \"" << r.map << "\", \"key\": \"" << r.key
+			   << "\", \"size\": " << r.size << ", \"unit\": \"" << r.unit
+			   << "\", \"samples\": " << r.statistics.samples
+			   << ", \"median\": " << r.statistics.median
+			   << ", \"p99\": " << r.statistics.p99
+			   << ", \"mean\": " << r.statistics.mean
+			   << ", \"min\": " << r.statistics.min
+			   << ", \"ops_per_sec\": " << r.ops_per_sec() << "}"
+			   << (i + 1 < records.size() ? ",\n" : "\n");
+		}
+		os << "]\n";
+	}
+
+	// the progress is printed to standard error while the cases run
+	bool verbose = true;
+
+private:
+	static void write_table_row(std::ostream &os, const Record &r)
+	{
+		os << std::left << std::setw(20) << r.suite << std::setw(24) << r.operation
+		   << std::setw(12) << r.map << std::setw(5) << r.key << std::right
+		   << std::setw(10) << r.size << std::fixed << std::setprecision(2)
+		   << std::setw(12) << r.statistics.median << std::setw(12)
+		   << r.statistics.p99 << " " << r.unit << std::defaultfloat << "\n";
+	}
+
+	std::vector<Record> records;
+};
+
+// the heap memory which was allocated by CountingAllocator
+struct AllocationCounter
+{
+	std::size_t current = 0;
+	std::size_t peak = 0;
+	std::size_t allocations = 0;
+};
+inline AllocationCounter allocation_counter;
+
+// Forwards to std::allocator and counts the bytes and allocations in
+// allocation_counter. Containers using it should not be used concurrently.
+template<typename T>
+struct CountingAllocator
+{
+	using value_type = T;
+	CountingAllocator() = default;
+	template<typename U>
+	CountingAllocator(const CountingAllocator<U> &) {}
+
+	T *allocate(std::size_t n)
+	{
+		allocation_counter.current += n * sizeof(T);
+		allocation_counter.peak = std::max(allocation_counter.peak, allocation_counter.current);
+		++allocation_counter.allocations;
+		return std::allocator<T>{}.allocate(n);
+	}
+	void deallocate(T *p, std::size_t n)
+	{
+		allocation_counter.current -= n * sizeof(T);
+		std::allocator<T>{}.deallocate(p, n);
+	}
+	template<typename U>
+	bool operator==(const CountingAllocator<U> &) const { return true; }
+	template<typename U>
+	bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+// reads the median of every record from a CSV file written by Report
+inline std::map<std::tuple<std::string, std::string, std::string, std::string, std::size_t>, double>
+read_baseline(std::istream &is)
+{
+	std::map<std::tuple<std::string, std::string, std::string, std::string, std::size_t>, double> medians;
+	std::string line;
+	std::getline(is, line);
+	while(std::getline(is, line))
+	{
+		std::vector<std::string> fields;
+		std::stringstream ss{line};
+		for(std::string field; std::getline(ss, field, ',');) fields.push_back(field);
+		if(fields.size() < 8) continue;
+		medians[{fields[0], fields[1], fields[2], fields[3], std::stoul(fields[4])}] =
+			std::stod(fields[7]);
+	}
+	return medians;
+}
+
+// Compares the timings of stroupo in the core suite with the baseline.
+// Returns false if one of their medians is slower than the baseline by more
+// than threshold, which is a fraction of the baseline.
+inline bool check_regressions(const Report &report, std::istream &baseline,
+							  double threshold, std::ostream &os)
+{
+	const auto medians = read_baseline(baseline);
+	bool passed = true;
+	for(const Record &r : report.results())
+	{
+		if(r.suite != "core" || r.map != "stroupo") continue;
+		const auto it = medians.find(r.id());
+		if(it == medians.end())
+		{
+			os << "no baseline: " << r.operation << " " << r.key << " " << r.size << "\n";
+			continue;
+		}
+		const double change = r.statistics.median / it->second - 1;
+		const bool regressed = change > threshold;
+		passed = passed && !regressed;
+		os << (regressed ? "REGRESSION " : "ok         ") << std::left
+		   << std::setw(24) << r.operation << std::setw(5) << r.key << std::right
+		   << std::setw(10) << r.size << std::fixed << std::setprecision(2)
+		   << std::setw(10) << it->second << " -> " << std::setw(8)
+		   << r.statistics.median << " ns/op (" << std::showpos
+		   << 100 * change << "%)" << std::noshowpos << std::defaultfloat << "\n";
+	}
+	return passed;
+}
+
+#endif  // STROUPO_BENCH_HARNESS_H_
@@ -0,0 +1,170 @@
+/*
+Generators for realistic sequences of operations.
+A workload refers to its keys by their index in a universe of distinct keys,
+so the same workload can be replayed with integer and string keys. The keys
+with an index below preload are inserted before the workload is replayed.
+- zipf: lookups of Zipf distributed keys, where few hot keys get most of
+  the lookups
+- churn: a sliding window of live keys, where every step inserts a new key,
+  erases the oldest one and looks up a live one
+- ycsb: the core workloads A to D of the Yahoo! Cloud Serving Benchmark
+- trace: a recorded log with one operation and key per line
+*/
+
+#ifndef STROUPO_BENCH_WORKLOADS_H_
+#define STROUPO_BENCH_WORKLOADS_H_
+
+#include<algorithm>
+#include<cctype>
+#include<cmath>
+#include<cstddef>
+#include<fstream>
+#include<numeric>
+#include<random>
+#include<stdexcept>
+#include<string>
+#include<unordered_map>
+#include<utility>
+#include<vector>
+
+
+enum class Op : char { insert, lookup, erase, update };
+
+struct Workload
+{
+	std::string name;
+	// the number of distinct keys
+	std::size_t key_count = 0;
+	std::size_t preload = 0;
+	std::vector<std::pair<Op, std::size_t>> operations;
+};
+
+// Draws ranks in [0, n) where rank i has a probability proportional to
+// 1 / (i + 1)^theta. It is the approximation by Gray et al. which is used by
+// YCSB. Its setup takes O(n) and every draw takes O(1).
+class ZipfGenerator
+{
+public:
+	ZipfGenerator(std::size_t n, double theta = 0.99)
+		: n(n), theta(theta), alpha(1 / (1 - theta))
+	{
+		for(std::size_t i = 1; i <= n; ++i) zetan += 1 / std::pow(i, theta);
+		const double zeta2 = 1 + 1 / std::pow(2, theta);
+		eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan);
+	}
+	template<typename Rng>
+	std::size_t operator()(Rng &rng)
+	{
+		const double u = std::uniform_real_distribution<double>{}(rng);
+		const double uz = u * zetan;
+		if(uz < 1) return 0;
+		if(uz < 1 + std::pow(0.5, theta)) return 1;
+		const auto rank = static_cast<std::size_t>(n * std::pow(eta * u - eta + 1, alpha));
+		return std::min(rank, n - 1);
+	}
+private:
+	std::size_t n;
+	double theta;
+	double alpha;
+	double zetan = 0;
+	double eta;
+};
+
+// The ranks are scattered over the keys, otherwise the hot keys would be the
+// ones inserted first.
+inline Workload zipf_workload(std::size_t key_count,
+							  std::size_t operation_count,
+							  double theta,
+							  unsigned seed = 42)
+{
+	std::mt19937_64 rng{seed};
+	std::vector<std::size_t> keys(key_count);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), rng);
+	ZipfGenerator zipf{key_count, theta};
+	Workload w{"zipf-" + std::to_string(theta).substr(0, 4), key_count, key_count, {}};
+	w.operations.reserve(operation_count);
+	for(std::size_t i = 0; i < operation_count; ++i)
+		w.operations.push_back({Op::lookup, keys[zipf(rng)]});
+	return w;
+}
+
+inline Workload churn_workload(std::size_t window,
+							   std::size_t step_count,
+							   unsigned seed = 42)
+{
+	std::mt19937_64 rng{seed};
+	Workload w{"churn", window + step_count, window, {}};
+	w.operations.reserve(3 * step_count);
+	for(std::size_t i = 0; i < step_count; ++i)
+	{
+		w.operations.push_back({Op::insert, window + i});
+		w.operations.push_back({Op::erase, i});
+		const std::size_t live = std::uniform_int_distribution<std::size_t>{i + 1, window + i}(rng);
+		w.operations.push_back({Op::lookup, live});
+	}
+	return w;
+}
+
+// Workload A has 50% reads and 50% updates, B 95% reads and 5% updates and
+// C only reads. All of them read Zipf distributed keys. Workload D has 95%
+// reads and 5% inserts of new keys, where the reads prefer the latest keys.
+inline Workload ycsb_workload(char type,
+							  std::size_t record_count,
+							  std::size_t operation_count,
+							  unsigned seed = 42)
+{
+	const double reads = type == 'A' ? 0.5 : type == 'C' ? 1.0 : 0.95;
+	std::mt19937_64 rng{seed};
+	std::bernoulli_distribution is_read{reads};
+	std::vector<std::size_t> keys(record_count);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), rng);
+	ZipfGenerator zipf{record_count};
+	const bool latest = type == 'D';
+	Workload w{std::string{"ycsb-"} + char(std::tolower(type)),
+			   latest ? record_count + operation_count : record_count, record_count, {}};
+	w.operations.reserve(operation_count);
+	std::size_t inserted = record_count;
+	for(std::size_t i = 0; i < operation_count; ++i)
+	{
+		if(is_read(rng))
+		{
+			const std::size_t rank = zipf(rng);
+			const std::size_t key = latest ? inserted - 1 - std::min(rank, inserted - 1) : keys[rank];
+			w.operations.push_back({Op::lookup, key});
+		}
+		else if(latest) w.operations.push_back({Op::insert, inserted++});
+		else w.operations.push_back({Op::update, keys[zipf(rng)]});
+	}
+	w.key_count = inserted;
+	return w;
+}
+
+// Reads a trace with lines of the form "<operation> <key>". The operation is
+// one of insert, lookup, erase and update. The distinct keys of the trace are
+// stored in keys in the order of their first occurrence. Throws if the file
+// cannot be read or contains an unknown operation.
+inline Workload trace_workload(const std::string &path, std::vector<std::string> &keys)
+{
+	std::ifstream file{path};
+	if(!file) throw std::runtime_error("cannot read the trace " + path);
+	const std::unordered_map<std::string, Op> ops{
+		{"insert", Op::insert}, {"lookup", Op::lookup},
+		{"erase", Op::erase}, {"update", Op::update}};
+	std::unordered_map<std::string, std::size_t> indices;
+	Workload w{"trace", 0, 0, {}};
+	std::string op, key;
+	while(file >> op >> key)
+	{
+		const auto it = ops.find(op);
+		if(it == ops.end()) throw std::runtime_error("unknown operation " + op + " in " + path);
+		const auto index = indices.insert({key, keys.size()});
+		if(index.second) keys.push_back(key);
+		w.operations.push_back({it->second, index.first->second});
+	}
+	w.key_count = keys.size();
+	return w;
+}
+
+#endif  // STROUPO_BENCH_WORKLOADS_H_
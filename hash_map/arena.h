@@ -0,0 +1,131 @@
+#ifndef STROUPO_HASH_MAP_ARENA_H_
+#define STROUPO_HASH_MAP_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace stroupo {
+
+// A monotonic arena hands out memory from large blocks. Deallocation is a
+// no-op and all memory is returned at once by 'release' or the destructor.
+// Requests larger than the block size get their own block.
+class arena {
+ public:
+  static constexpr std::size_t default_block_size = std::size_t{1} << 16;
+
+  // Constructors, Destructors and Assignments
+  explicit arena(std::size_t block_size = default_block_size)
+      : block_size_{block_size} {}
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+  ~arena() { release(); }
+
+  // Allocation
+  void* allocate(std::size_t bytes,
+                 std::size_t alignment = alignof(std::max_align_t));
+  void deallocate(void*, std::size_t) noexcept {}
+  void release() noexcept;
+
+  // Observers
+  std::size_t block_size() const noexcept { return block_size_; }
+  std::size_t block_count() const noexcept { return blocks_.size(); }
+  std::size_t allocated_bytes() const noexcept { return allocated_bytes_; }
+
+ private:
+  struct block {
+    char* data;
+    std::size_t size;
+  };
+
+  std::size_t block_size_;
+  std::vector<block> blocks_{};
+  char* current_{nullptr};
+  char* end_{nullptr};
+  std::size_t allocated_bytes_{0};
+};
+
+inline void* arena::allocate(std::size_t bytes, std::size_t alignment) {
+  const auto aligned = [alignment](char* p) {
+    const auto address = reinterpret_cast<std::uintptr_t>(p);
+    return p + ((alignment - address % alignment) % alignment);
+  };
+  if (current_) {
+    char* p = aligned(current_);
+    if (p <= end_ && bytes <= static_cast<std::size_t>(end_ - p)) {
+      current_ = p + bytes;
+      allocated_bytes_ += bytes;
+      return p;
+    }
+  }
+  // Blocks come from operator new and are therefore suitably aligned for
+  // every fundamental alignment. Extended alignments get some extra space.
+  const auto padding =
+      (alignment > alignof(std::max_align_t)) ? alignment : std::size_t{0};
+  const auto size = std::max(block_size_, bytes + padding);
+  auto data = static_cast<char*>(::operator new(size));
+  blocks_.push_back({data, size});
+  char* p = aligned(data);
+  // An oversized request does not discard the rest of the current block.
+  if (size == block_size_ || !current_) {
+    current_ = p + bytes;
+    end_ = data + size;
+  }
+  allocated_bytes_ += bytes;
+  return p;
+}
+
+inline void arena::release() noexcept {
+  for (auto& b : blocks_) ::operator delete(b.data);
+  blocks_.clear();
+  current_ = end_ = nullptr;
+  allocated_bytes_ = 0;
+}
+
+// A standard allocator which takes its memory from an arena. Copies and
+// rebound copies share the arena. It is not default constructible.
+template <typename T>
+class arena_allocator {
+ public:
+  // Member Types
+  using value_type = T;
+
+  // Constructors, Destructors and Assignments
+  explicit arena_allocator(arena& a) noexcept : arena_{&a} {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+      : arena_{other.resource()} {}
+
+  // Allocation
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, std::size_t n) noexcept {
+    arena_->deallocate(p, n * sizeof(T));
+  }
+
+  // Observers
+  arena* resource() const noexcept { return arena_; }
+
+ private:
+  arena* arena_;
+};
+
+template <typename T, typename U>
+inline bool operator==(const arena_allocator<T>& lhs,
+                       const arena_allocator<U>& rhs) noexcept {
+  return lhs.resource() == rhs.resource();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const arena_allocator<T>& lhs,
+                       const arena_allocator<U>& rhs) noexcept {
+  return !(lhs == rhs);
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_ARENA_H_
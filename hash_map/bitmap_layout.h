@@ -0,0 +1,131 @@
+#ifndef STROUPO_HASH_MAP_BITMAP_LAYOUT_H_
+#define STROUPO_HASH_MAP_BITMAP_LAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <hash_map/node_layout.h>
+#include <hash_map/policy.h>
+
+namespace stroupo {
+
+namespace detail {
+
+inline int count_trailing_zeros(std::uint64_t mask) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(mask);
+#else
+  int n = 0;
+  for (; !(mask & 1); mask >>= 1) ++n;
+  return n;
+#endif
+}
+
+}  // namespace detail
+
+// Extends another layout by a bitmap with one bit per slot which is set for
+// full slots. Iterations skip 64 slots which are not full at once. Hence,
+// iterating over sparse tables, like reserved ones or ones after mass
+// erasures, does not touch every slot. The bitmap costs one bit per slot and
+// every modification of a slot updates it.
+template <typename Layout = node_layout>
+struct bitmap_layout {
+  using category = layout_policy_tag;
+
+  template <typename Key, typename T, typename Allocator,
+            bool Store_hash = false>
+  class storage;
+};
+
+template <typename Layout>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+class bitmap_layout<Layout>::storage
+    : public Layout::template storage<Key, T, Allocator, Store_hash> {
+  // Internal Member Types
+  using base = typename Layout::template storage<Key, T, Allocator, Store_hash>;
+  using word_type = std::uint64_t;
+  using word_allocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<word_type>;
+  static constexpr std::size_t word_bits = 64;
+
+ public:
+  // Member Types
+  using typename base::size_type;
+
+  // Constructors, Destructors and Assignments
+  storage() = default;
+  explicit storage(size_type count, const Allocator& alloc = Allocator{})
+      : base(count, alloc), bits_((count + word_bits - 1) / word_bits, alloc) {}
+
+  // Capacity
+  void swap(storage& other) noexcept {
+    base::swap(other);
+    bits_.swap(other.bits_);
+  }
+  void reserve(size_type count) {
+    base::reserve(count);
+    bits_.reserve((count + word_bits - 1) / word_bits);
+  }
+  void resize(size_type count) {
+    base::resize(count);
+    bits_.resize((count + word_bits - 1) / word_bits);
+  }
+  std::size_t memory_bytes() const noexcept {
+    return base::memory_bytes() + bits_.capacity() * sizeof(word_type);
+  }
+
+  // Slot States
+  size_type next_full(size_type index) const;
+
+  // Slot Modifiers
+  template <typename K, typename V>
+  void construct(size_type index, std::size_t hash, K&& key, V&& value) {
+    base::construct(index, hash, std::forward<K>(key), std::forward<V>(value));
+    bits_[index / word_bits] |= word_type{1} << (index % word_bits);
+  }
+  void destroy(size_type index) {
+    base::destroy(index);
+    clear(index);
+  }
+  void erase(size_type index) {
+    base::erase(index);
+    clear(index);
+  }
+  // The moved-from slot keeps its state like in the extended layout.
+  void move(size_type from, size_type to) {
+    base::move(from, to);
+    const auto bit = (bits_[from / word_bits] >> (from % word_bits)) & 1;
+    clear(to);
+    bits_[to / word_bits] |= bit << (to % word_bits);
+  }
+
+ private:
+  void clear(size_type index) {
+    bits_[index / word_bits] &= ~(word_type{1} << (index % word_bits));
+  }
+
+ private:
+  std::vector<word_type, word_allocator> bits_;
+};
+
+template <typename Layout>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+auto bitmap_layout<Layout>::storage<Key, T, Allocator, Store_hash>::next_full(
+    size_type index) const -> size_type {
+  if (index >= this->size()) return this->size();
+  auto word = index / word_bits;
+  // The bits in front of index are masked out of its word.
+  auto bits = bits_[word] & (~word_type{0} << (index % word_bits));
+  while (!bits) {
+    if (++word == bits_.size()) return this->size();
+    bits = bits_[word];
+  }
+  return word * word_bits + detail::count_trailing_zeros(bits);
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_BITMAP_LAYOUT_H_
@@ -0,0 +1,276 @@
+#ifndef STROUPO_HASH_MAP_CONCURRENT_HASH_MAP_H_
+#define STROUPO_HASH_MAP_CONCURRENT_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <hash_map/hash.h>
+#include <hash_map/hash_map.h>
+
+namespace stroupo {
+
+// A hash map which can be used by many threads at once. The keys are
+// distributed over a power of two number of shards. Every shard is a hash_map
+// guarded by its own reader-writer lock. Hence, threads only contend if they
+// access the same shard and readers of a shard do not block each other.
+//
+// References to stored values would outlive the locks. Therefore, values are
+// only accessed through callbacks which are invoked while the lock is held.
+// The callbacks must not access the same concurrent_hash_map.
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename Key_equal = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>,
+          typename... Policies>
+class concurrent_hash_map {
+  // Lookups only hold a shared lock. Hence, they must not count probes.
+  static_assert(
+      !select_policy_t<stats_policy_tag, no_stats, Policies...>::enabled,
+      "The shards of a concurrent_hash_map cannot collect stats.");
+
+ public:
+  // Member Types
+  using shard_type =
+      hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>;
+  using key_type = typename shard_type::key_type;
+  using mapped_type = typename shard_type::mapped_type;
+  using value_type = typename shard_type::value_type;
+  using size_type = typename shard_type::size_type;
+  using hasher = typename shard_type::hasher;
+  using key_equal = typename shard_type::key_equal;
+  using allocator_type = typename shard_type::allocator_type;
+
+  // Constructors, Destructors and Assignments
+  // The shard count is rounded up to the next power of two. The shards and
+  // the choice of the shard use copies of the given hasher.
+  concurrent_hash_map() : concurrent_hash_map{default_shard_count()} {}
+  explicit concurrent_hash_map(size_type shard_count,
+                               const hasher& hash = hasher{});
+  concurrent_hash_map(const concurrent_hash_map&) = delete;
+  concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+  static size_type default_shard_count();
+
+  // Capacity
+  // The result is only exact if no other thread modifies the map.
+  size_type size() const;
+  bool empty() const { return size() == 0; }
+  size_type shard_count() const noexcept { return shards_.size(); }
+  hasher hash_function() const { return hash_; }
+
+  // Modifiers
+  // Existing keys get the new value assigned. Returns whether the key was
+  // inserted.
+  bool insert(const value_type& value);
+  bool insert(value_type&& value);
+  template <typename... Args>
+  bool try_emplace(const key_type& key, Args&&... args);
+  size_type erase(const key_type& key);
+  // Calls f(mapped_type&) for the value of the given key if it is contained.
+  template <typename Function>
+  bool update(const key_type& key, Function f);
+  void clear();
+
+  // Lookup
+  // Calls f(const mapped_type&) for the value of the given key if it is
+  // contained.
+  template <typename Function>
+  bool find(const key_type& key, Function f) const;
+  bool contains(const key_type& key) const;
+
+  // Shards
+  // Calls f(shard_type&) for every shard. Only one shard is locked at a time.
+  template <typename Function>
+  void for_each_shard(Function f);
+  template <typename Function>
+  void for_each_shard(Function f) const;
+
+ private:
+  // Every shard gets its own cache lines to prevent false sharing.
+  struct alignas(64) shard {
+    mutable std::shared_mutex mutex{};
+    shard_type map{};
+  };
+
+  // Internal Member Functions
+  shard& shard_of(const key_type& key) { return shards_[shard_index(key)]; }
+  const shard& shard_of(const key_type& key) const {
+    return shards_[shard_index(key)];
+  }
+  size_type shard_index(const key_type& key) const;
+  static size_type round_up_to_power_of_two(size_type count) {
+    size_type result = 1;
+    while (result < count) result <<= 1;
+    return result;
+  }
+
+ private:
+  // Internal Member Variables
+  hasher hash_;
+  std::vector<shard> shards_;
+  int shift_;
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                    Policies...>::concurrent_hash_map(size_type shard_count,
+                                                      const hasher& hash)
+    : hash_{hash}, shards_(round_up_to_power_of_two(shard_count)), shift_{64} {
+  for (auto n = shards_.size(); n >>= 1;) --shift_;
+  for (auto& s : shards_) s.map = shard_type{hash_};
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::default_shard_count() -> size_type {
+  // More shards than threads make collisions of threads less likely.
+  return 4 * std::max(1u, std::thread::hardware_concurrency());
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::shard_index(const key_type& key) const
+    -> size_type {
+  // The shards use the upper bits of the remixed hash. The maps inside the
+  // shards reduce the hash itself, be it by its lower bits or by the upper
+  // bits of a multiplicative hash. Otherwise, all keys of a shard would share
+  // the bits which choose their slot and every shard would only use a
+  // fraction of its slots.
+  const std::uint64_t hash = hash_(key);
+  if (shift_ == 64) return 0;
+  return detail::murmur_mix(hash) >> shift_;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::size() const -> size_type {
+  size_type result = 0;
+  for (const auto& s : shards_) {
+    std::shared_lock lock{s.mutex};
+    result += s.map.size();
+  }
+  return result;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+bool concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::insert(const value_type& value) {
+  auto& s = shard_of(value.first);
+  std::unique_lock lock{s.mutex};
+  return s.map.insert_or_assign(value.first, value.second).second;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+bool concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::insert(value_type&& value) {
+  auto& s = shard_of(value.first);
+  std::unique_lock lock{s.mutex};
+  return s.map.insert_or_assign(value.first, std::move(value.second)).second;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename... Args>
+bool concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::try_emplace(const key_type& key,
+                                                   Args&&... args) {
+  auto& s = shard_of(key);
+  std::unique_lock lock{s.mutex};
+  return s.map.try_emplace(key, std::forward<Args>(args)...).second;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::erase(const key_type& key)
+    -> size_type {
+  auto& s = shard_of(key);
+  std::unique_lock lock{s.mutex};
+  return s.map.erase(key);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+bool concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::update(const key_type& key,
+                                              Function f) {
+  auto& s = shard_of(key);
+  std::unique_lock lock{s.mutex};
+  const auto it = s.map.find(key);
+  if (it == s.map.end()) return false;
+  f(it->second);
+  return true;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::clear() {
+  for (auto& s : shards_) {
+    std::unique_lock lock{s.mutex};
+    s.map = shard_type{hash_, s.map.get_allocator()};
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+bool concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::find(const key_type& key,
+                                            Function f) const {
+  const auto& s = shard_of(key);
+  std::shared_lock lock{s.mutex};
+  const auto it = s.map.find(key);
+  if (it == s.map.end()) return false;
+  f(it->second);
+  return true;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+bool concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::contains(const key_type& key) const {
+  const auto& s = shard_of(key);
+  std::shared_lock lock{s.mutex};
+  return s.map.contains(key);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+void concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::for_each_shard(Function f) {
+  for (auto& s : shards_) {
+    std::unique_lock lock{s.mutex};
+    f(s.map);
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+void concurrent_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::for_each_shard(Function f) const {
+  for (const auto& s : shards_) {
+    std::shared_lock lock{s.mutex};
+    f(s.map);
+  }
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_CONCURRENT_HASH_MAP_H_
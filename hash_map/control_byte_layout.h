@@ -0,0 +1,297 @@
+#ifndef STROUPO_HASH_MAP_CONTROL_BYTE_LAYOUT_H_
+#define STROUPO_HASH_MAP_CONTROL_BYTE_LAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <hash_map/policy.h>
+#include <hash_map/prefetch.h>
+
+namespace stroupo {
+
+namespace detail {
+
+// A control byte is negative for empty and deleted slots. For full slots it
+// holds seven bits of the hash value of the stored key.
+using control_t = signed char;
+constexpr control_t control_empty = -128;
+constexpr control_t control_deleted = -2;
+
+inline int count_trailing_zeros(std::uint32_t mask) {
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int n = 0;
+  for (; !(mask & 1); mask >>= 1) ++n;
+  return n;
+#endif
+}
+
+// A group is a view of consecutive control bytes. Every match returns a bit
+// mask whose n-th bit is set if the n-th control byte matches.
+#if defined(__AVX2__)
+class control_group {
+ public:
+  static constexpr std::size_t width = 32;
+  using mask_type = std::uint32_t;
+
+  explicit control_group(const control_t* p)
+      : data_{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))} {}
+
+  mask_type match(control_t c) const {
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(c), data_));
+  }
+  mask_type match_empty() const { return match(control_empty); }
+  mask_type match_empty_or_deleted() const {
+    return _mm256_movemask_epi8(data_);
+  }
+  mask_type match_full() const { return ~match_empty_or_deleted(); }
+
+ private:
+  __m256i data_;
+};
+#elif defined(__SSE2__)
+class control_group {
+ public:
+  static constexpr std::size_t width = 16;
+  using mask_type = std::uint32_t;
+
+  explicit control_group(const control_t* p)
+      : data_{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))} {}
+
+  mask_type match(control_t c) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), data_));
+  }
+  mask_type match_empty() const { return match(control_empty); }
+  mask_type match_empty_or_deleted() const { return _mm_movemask_epi8(data_); }
+  mask_type match_full() const { return match_empty_or_deleted() ^ 0xffff; }
+
+ private:
+  __m128i data_;
+};
+#else
+class control_group {
+ public:
+  static constexpr std::size_t width = 16;
+  using mask_type = std::uint32_t;
+
+  explicit control_group(const control_t* p) : data_{p} {}
+
+  mask_type match(control_t c) const {
+    mask_type mask = 0;
+    for (std::size_t i = 0; i < width; ++i)
+      mask |= mask_type{data_[i] == c} << i;
+    return mask;
+  }
+  mask_type match_empty() const { return match(control_empty); }
+  mask_type match_empty_or_deleted() const {
+    mask_type mask = 0;
+    for (std::size_t i = 0; i < width; ++i)
+      mask |= mask_type{data_[i] < 0} << i;
+    return mask;
+  }
+  mask_type match_full() const { return match_empty_or_deleted() ^ 0xffff; }
+
+ private:
+  const control_t* data_;
+};
+#endif
+
+}  // namespace detail
+
+// The slot states are kept in a separate array of control bytes. Probing
+// compares a whole group of control bytes at once and only touches the keys
+// whose control byte matches the hash value. If Store_hash is set, every slot
+// also keeps the hash value of its key.
+struct control_byte_layout {
+  using category = layout_policy_tag;
+
+  template <typename Key, typename T, typename Allocator,
+            bool Store_hash = false>
+  class storage;
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+class control_byte_layout::storage {
+  // Internal Member Types
+  struct plain_slot;
+  struct hashed_slot;
+  using slot = std::conditional_t<Store_hash, hashed_slot, plain_slot>;
+  using control_t = detail::control_t;
+  template <typename U>
+  using allocator_for =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  using container = std::vector<slot, allocator_for<slot>>;
+
+ public:
+  // Member Types
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = typename container::size_type;
+  using difference_type = typename container::difference_type;
+  using group_type = detail::control_group;
+
+  // Member Constants
+  static constexpr size_type group_width = group_type::width;
+  static constexpr size_type min_capacity = group_width;
+  // Probe distances are not stored.
+  static constexpr size_type max_distance = 0;
+
+  // Constructors, Destructors and Assignments
+  storage() = default;
+  // The first group_width - 1 control bytes are mirrored behind the end.
+  // Hence, a group can be loaded at every index without wrapping around.
+  explicit storage(size_type count, const Allocator& alloc = Allocator{})
+      : slots_(count, alloc),
+        control_(count + group_width - 1, detail::control_empty, alloc) {}
+
+  Allocator get_allocator() const { return Allocator(slots_.get_allocator()); }
+
+  // Capacity
+  size_type size() const noexcept { return slots_.size(); }
+  void swap(storage& other) noexcept {
+    slots_.swap(other.slots_);
+    control_.swap(other.control_);
+  }
+  void reserve(size_type count) {
+    slots_.reserve(count);
+    control_.reserve(count + group_width - 1);
+  }
+  // Appends empty slots until there are count slots. The mirrored control
+  // bytes of an empty table are empty as well.
+  void resize(size_type count) {
+    slots_.resize(count);
+    control_.resize(count + group_width - 1, detail::control_empty);
+  }
+  std::size_t memory_bytes() const noexcept {
+    return slots_.capacity() * sizeof(slot) + control_.capacity();
+  }
+  std::size_t padding_bytes() const noexcept {
+    return size() * (sizeof(slot) - sizeof(key_type) - sizeof(mapped_type) -
+                     Store_hash * sizeof(std::size_t));
+  }
+
+  // Slot States
+  bool empty(size_type index) const {
+    return control_[index] == detail::control_empty;
+  }
+  bool full(size_type index) const { return control_[index] >= 0; }
+  bool deleted(size_type index) const {
+    return control_[index] == detail::control_deleted;
+  }
+  size_type next_full(size_type index) const;
+  group_type group(size_type index) const {
+    return group_type{&control_[index]};
+  }
+  void prefetch(size_type index) const {
+    detail::prefetch(&control_[index]);
+    detail::prefetch(&slots_[index]);
+  }
+  // Only available if Store_hash is set.
+  std::size_t hash(size_type index) const { return slots_[index].hash; }
+  static control_t fingerprint(std::size_t hash) {
+    // The upper bits of a multiplicative hash also differ for weak hashes.
+    // The factor differs from the one of fibonacci_reduction. Otherwise, keys
+    // with the same home index would get the same fingerprint.
+    return static_cast<control_t>(
+        (static_cast<std::uint64_t>(hash) * 0xff51afd7ed558ccdull) >> 57);
+  }
+
+  // Slot Access
+  const key_type& key(size_type index) const { return slots_[index].key; }
+  // Only used to move keys out of a table which is discarded afterwards.
+  key_type& key(size_type index) { return slots_[index].key; }
+  mapped_type& value(size_type index) { return slots_[index].value; }
+  const mapped_type& value(size_type index) const {
+    return slots_[index].value;
+  }
+  value_type& operator[](size_type index) {
+    return *reinterpret_cast<value_type*>(&slots_[index]);
+  }
+  const value_type& operator[](size_type index) const {
+    return *reinterpret_cast<const value_type*>(&slots_[index]);
+  }
+
+  // Slot Modifiers
+  template <typename K, typename V>
+  void construct(size_type index, std::size_t hash, K&& key, V&& value);
+  void destroy(size_type index) {
+    slots_[index] = slot{};
+    set_control(index, detail::control_empty);
+  }
+  void erase(size_type index) {
+    slots_[index] = slot{};
+    set_control(index, detail::control_deleted);
+  }
+  void move(size_type from, size_type to) {
+    slots_[to] = std::move(slots_[from]);
+    set_control(to, control_[from]);
+  }
+
+ private:
+  void set_control(size_type index, control_t control);
+
+ private:
+  container slots_;
+  std::vector<control_t, allocator_for<control_t>> control_;
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct control_byte_layout::storage<Key, T, Allocator, Store_hash>::plain_slot {
+  // Member Variables
+  // The order should no be changed.
+  // It is used for an reinterpret_cast to value_type.
+  key_type key{};
+  mapped_type value{};
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct control_byte_layout::storage<Key, T, Allocator, Store_hash>::hashed_slot
+    : plain_slot {
+  // Member Variables
+  std::size_t hash{};
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+auto control_byte_layout::storage<Key, T, Allocator, Store_hash>::next_full(
+    size_type index) const -> size_type {
+  for (; index < size(); index += group_width) {
+    auto mask = group(index).match_full();
+    // Mirrored control bytes behind the end must not be reported.
+    if (size() - index < group_width) mask &= (1u << (size() - index)) - 1;
+    if (mask) return index + detail::count_trailing_zeros(mask);
+  }
+  return size();
+}
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+template <typename K, typename V>
+void control_byte_layout::storage<Key, T, Allocator, Store_hash>::construct(
+    size_type index, std::size_t hash, K&& key, V&& value) {
+  slots_[index].key = std::forward<K>(key);
+  slots_[index].value = std::forward<V>(value);
+  if constexpr (Store_hash) slots_[index].hash = hash;
+  set_control(index, fingerprint(hash));
+}
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+void control_byte_layout::storage<Key, T, Allocator, Store_hash>::set_control(
+    size_type index, control_t control) {
+  control_[index] = control;
+  if (index < group_width - 1) control_[index + size()] = control;
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_CONTROL_BYTE_LAYOUT_H_
@@ -0,0 +1,61 @@
+#ifndef STROUPO_HASH_MAP_EXECUTION_H_
+#define STROUPO_HASH_MAP_EXECUTION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace stroupo {
+
+// Execution policies for bulk operations. They mirror std::execution but do
+// not depend on a parallel backend library.
+namespace execution {
+
+struct sequenced_policy {};
+
+// A thread count of zero uses one thread per hardware thread.
+struct parallel_policy {
+  std::size_t threads = 0;
+};
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy par{};
+
+}  // namespace execution
+
+namespace detail {
+
+inline std::size_t thread_count(std::size_t threads) {
+  if (threads != 0) return threads;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls f(t) for every t in [0, threads) on its own thread. The calling thread
+// runs f(0). The first exception thrown by any call is rethrown after all
+// threads have finished.
+template <typename Function>
+void parallel_for(std::size_t threads, Function f) {
+  std::vector<std::exception_ptr> errors(threads);
+  const auto run = [&](std::size_t t) {
+    try {
+      f(t);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(run, t);
+  run(0);
+  for (auto& worker : workers) worker.join();
+  for (auto& error : errors)
+    if (error) std::rethrow_exception(error);
+}
+
+}  // namespace detail
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_EXECUTION_H_
@@ -0,0 +1,431 @@
+#ifndef STROUPO_HASH_MAP_FROZEN_HASH_MAP_H_
+#define STROUPO_HASH_MAP_FROZEN_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hash_map/hash.h>
+#include <hash_map/hash_map.h>
+#include <hash_map/memory.h>
+#include <hash_map/reduction.h>
+#include <hash_map/serialization.h>
+
+namespace stroupo {
+
+namespace detail {
+
+inline int popcount(std::uint64_t bits) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(bits);
+#else
+  int n = 0;
+  for (; bits; bits &= bits - 1) ++n;
+  return n;
+#endif
+}
+
+// A minimal perfect hash function in the style of BBHash. Every level is a
+// bit array with gamma bits per key which was not placed by a previous level.
+// A key sets the bit at the position its hash value is mixed to. Keys which
+// share a bit with other keys are passed to the next level. The index of a
+// key is the number of set bits in front of its bit. Keys which are left
+// after the last level, like ones with equal hash values, are kept in a
+// sorted array.
+class frozen_function {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type gamma = 2;
+  static constexpr size_type max_levels = 32;
+  static constexpr size_type npos = ~size_type{0};
+
+  frozen_function() = default;
+  // Returns the keys of the hash values which could not be placed by a level
+  // in order of their hash values. They get the indices from level_count()
+  // onwards in this order.
+  std::vector<size_type> build(const std::vector<std::uint64_t>& hashes);
+
+  // The index of a placed hash value or npos, if its bit is not set in any
+  // level. The index of unknown hash values is arbitrary.
+  size_type index(std::uint64_t hash) const noexcept;
+  // The indices of the hash values which were left after the last level.
+  template <typename Function>
+  size_type find_remaining(std::uint64_t hash, Function matches) const;
+
+  size_type level_count() const noexcept { return placed_; }
+  std::size_t memory_bytes() const noexcept {
+    return lines_.capacity() * sizeof(line) +
+           levels_.capacity() * sizeof(level) +
+           remaining_.capacity() * sizeof(std::uint64_t);
+  }
+
+ private:
+  static constexpr size_type word_bits = 64;
+  static constexpr size_type line_words = 6;
+  static constexpr size_type count_bits = 9;
+
+  struct level {
+    // The position of the first bit and the number of bits.
+    size_type offset;
+    size_type size;
+  };
+  // The bits of all levels are stored in cache lines together with the number
+  // of set bits in front of them. Hence, a lookup which finds its bit loads
+  // one line and counts the bits of one word.
+  struct alignas(64) line {
+    // The set bits in front of the line.
+    std::uint64_t rank;
+    // The set bits in front of word k of the line in the k-th nine bits.
+    std::uint64_t counts;
+    std::uint64_t words[line_words];
+  };
+
+  static size_type position(std::uint64_t hash, size_type level,
+                            size_type size) noexcept {
+    const auto mixed = murmur_mix(hash ^ ((level + 1) * 0x9e3779b97f4a7c15ull));
+    return fastrange_reduction{size}.index(mixed);
+  }
+  static bool test(const std::vector<std::uint64_t>& bits,
+                   size_type i) noexcept {
+    return (bits[i / word_bits] >> (i % word_bits)) & 1;
+  }
+  static void set(std::vector<std::uint64_t>& bits, size_type i) noexcept {
+    bits[i / word_bits] |= std::uint64_t{1} << (i % word_bits);
+  }
+
+ private:
+  std::vector<level> levels_{};
+  std::vector<line> lines_{};
+  std::vector<std::uint64_t> remaining_{};
+  size_type placed_{0};
+};
+
+inline auto frozen_function::build(const std::vector<std::uint64_t>& hashes)
+    -> std::vector<size_type> {
+  *this = frozen_function{};
+  std::vector<size_type> keys(hashes.size());
+  for (size_type i = 0; i < keys.size(); ++i) keys[i] = i;
+
+  std::vector<std::uint64_t> bits{};
+  std::vector<std::uint64_t> collided{};
+  for (size_type l = 0; l < max_levels && !keys.empty(); ++l) {
+    const auto words = (gamma * keys.size() + word_bits - 1) / word_bits;
+    const level current{bits.size() * word_bits, words * word_bits};
+    levels_.push_back(current);
+    // Both arrays are filled in one pass. A key ends up in the level if its
+    // bit was set once and never collided.
+    std::vector<std::uint64_t> seen(words);
+    collided.assign(words, 0);
+    for (const auto key : keys) {
+      const auto p = position(hashes[key], l, current.size);
+      if (test(seen, p))
+        set(collided, p);
+      else
+        set(seen, p);
+    }
+    for (size_type w = 0; w < words; ++w) seen[w] &= ~collided[w];
+    bits.insert(bits.end(), seen.begin(), seen.end());
+    keys.erase(std::remove_if(keys.begin(), keys.end(),
+                              [&](size_type key) {
+                                return !test(collided, position(hashes[key], l,
+                                                                current.size));
+                              }),
+               keys.end());
+  }
+  placed_ = hashes.size() - keys.size();
+
+  lines_.resize((bits.size() + line_words - 1) / line_words);
+  size_type count = 0;
+  for (size_type w = 0; w < bits.size(); ++w) {
+    auto& target = lines_[w / line_words];
+    const auto k = w % line_words;
+    if (k == 0) target.rank = count;
+    target.counts |= std::uint64_t(count - target.rank) << (count_bits * k);
+    target.words[k] = bits[w];
+    count += popcount(bits[w]);
+  }
+
+  std::sort(keys.begin(), keys.end(), [&](size_type a, size_type b) {
+    return hashes[a] < hashes[b];
+  });
+  remaining_.reserve(keys.size());
+  for (const auto key : keys) remaining_.push_back(hashes[key]);
+  return keys;
+}
+
+inline auto frozen_function::index(std::uint64_t hash) const noexcept
+    -> size_type {
+  for (size_type l = 0; l < levels_.size(); ++l) {
+    const auto i = levels_[l].offset + position(hash, l, levels_[l].size);
+    const auto& target = lines_[i / word_bits / line_words];
+    const auto k = i / word_bits % line_words;
+    const auto word = target.words[k];
+    const auto bit = i % word_bits;
+    if (!((word >> bit) & 1)) continue;
+    const auto below = (std::uint64_t{1} << bit) - 1;
+    return target.rank +
+           ((target.counts >> (count_bits * k)) & ((1 << count_bits) - 1)) +
+           popcount(word & below);
+  }
+  return npos;
+}
+
+template <typename Function>
+auto frozen_function::find_remaining(std::uint64_t hash,
+                                     Function matches) const -> size_type {
+  auto it = std::lower_bound(remaining_.begin(), remaining_.end(), hash);
+  for (; it != remaining_.end() && *it == hash; ++it) {
+    const auto i = placed_ + (it - remaining_.begin());
+    if (matches(i)) return i;
+  }
+  return npos;
+}
+
+}  // namespace detail
+
+// An immutable map for large sets of keys which do not change after they
+// were collected, e.g. in a hash_map. The keys are placed by a minimal
+// perfect hash function which costs about 4.4 bits per key. Hence, the
+// entries are stored in a dense array without empty slots. A lookup hashes
+// the key, tests 1.6 bits on average and compares one key. There is no probe
+// sequence, but the tests depend on each other. Hence, lookups of keys in
+// cache are slower than the ones of hash_map. The construction takes linear
+// time and throws std::invalid_argument if two keys are equal.
+template <typename Key, typename T, typename Hash = hash<Key>,
+          typename Key_equal = std::equal_to<Key>>
+class frozen_hash_map {
+ public:
+  // Member Types
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = Key_equal;
+  using reference = const value_type&;
+  using const_reference = const value_type&;
+  using iterator = const value_type*;
+  using const_iterator = const value_type*;
+
+  // Constructors, Destructors and Assignments
+  frozen_hash_map() = default;
+  explicit frozen_hash_map(const hasher& hash) : hash_{hash} {}
+  // Builds the map from a range of key-value pairs.
+  template <typename Input_iterator>
+  frozen_hash_map(Input_iterator first, Input_iterator last,
+                  const hasher& hash = hasher{});
+  // A hash map with the same hasher passes on its seed.
+  template <typename E, typename A, typename... Policies>
+  explicit frozen_hash_map(
+      const hash_map<Key, T, Hash, E, A, Policies...>& map)
+      : frozen_hash_map(map.begin(), map.end(), map.hash_function()) {}
+  template <typename H, typename E, typename A, typename... Policies>
+  explicit frozen_hash_map(const hash_map<Key, T, H, E, A, Policies...>& map)
+      : frozen_hash_map(map.begin(), map.end()) {}
+
+  // Iterators
+  const_iterator begin() const noexcept { return entries_.data(); }
+  const_iterator end() const noexcept { return begin() + entries_.size(); }
+
+  // Capacity
+  bool empty() const noexcept { return entries_.empty(); }
+  size_type size() const noexcept { return entries_.size(); }
+  hasher hash_function() const { return hash_; }
+
+  // Lookup
+  const_iterator find(const key_type& key) const;
+  bool contains(const key_type& key) const { return find(key) != end(); }
+  size_type count(const key_type& key) const { return contains(key); }
+  const mapped_type& at(const key_type& key) const {
+    const auto it = find(key);
+    if (it == end()) throw std::out_of_range{"The given key is not stored!"};
+    return it->second;
+  }
+
+  // Statistics
+  // The entries and the hash function. There is no table with empty slots.
+  hash_map_memory memory_usage() const;
+
+  // Serialization
+  // Writes the entries in the snapshot format of hash_map. Hence, a hash_map
+  // can load the snapshot and vice versa.
+  void save(std::ostream& out) const;
+  // Replaces the content by a snapshot. If it was written with the same
+  // hasher, the stored hash values are used to rebuild the hash function.
+  // Throws std::runtime_error for corrupt snapshots and leaves the map
+  // unchanged.
+  void load(std::istream& in);
+
+ private:
+  // Moves the entries to the indices of the hash function.
+  void build(std::vector<value_type> entries,
+             const std::vector<std::uint64_t>& hashes);
+
+ private:
+  hasher hash_{};
+  std::vector<value_type> entries_{};
+  detail::frozen_function function_{};
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+template <typename Input_iterator>
+frozen_hash_map<Key, T, Hash, Key_equal>::frozen_hash_map(Input_iterator first,
+                                                          Input_iterator last,
+                                                          const hasher& hash)
+    : hash_{hash} {
+  std::vector<value_type> entries{};
+  std::vector<std::uint64_t> hashes{};
+  if constexpr (std::is_base_of_v<
+                    std::forward_iterator_tag,
+                    typename std::iterator_traits<
+                        Input_iterator>::iterator_category>) {
+    const auto n = static_cast<size_type>(std::distance(first, last));
+    entries.reserve(n);
+    hashes.reserve(n);
+  }
+  for (; first != last; ++first) {
+    const auto& [key, value] = *first;
+    entries.emplace_back(key, value);
+    hashes.push_back(hash_(entries.back().first));
+  }
+  build(std::move(entries), hashes);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void frozen_hash_map<Key, T, Hash, Key_equal>::build(
+    std::vector<value_type> entries, const std::vector<std::uint64_t>& hashes) {
+  detail::frozen_function function{};
+  const auto remaining = function.build(hashes);
+  // Equal keys have equal hash values and are never placed by a level.
+  for (size_type i = 0; i < remaining.size(); ++i) {
+    for (auto j = i + 1;
+         j < remaining.size() && hashes[remaining[j]] == hashes[remaining[i]];
+         ++j) {
+      if (key_equal{}(entries[remaining[i]].first,
+                      entries[remaining[j]].first))
+        throw std::invalid_argument{"The given keys are not unique!"};
+    }
+  }
+
+  std::vector<size_type> order(entries.size());
+  for (size_type i = 0; i < remaining.size(); ++i)
+    order[function.level_count() + i] = remaining[i];
+  for (size_type i = 0; i < entries.size(); ++i) {
+    const auto index = function.index(hashes[i]);
+    if (index != function.npos) order[index] = i;
+  }
+  std::vector<value_type> sorted{};
+  sorted.reserve(entries.size());
+  for (const auto i : order) sorted.push_back(std::move(entries[i]));
+
+  entries_ = std::move(sorted);
+  function_ = std::move(function);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+auto frozen_hash_map<Key, T, Hash, Key_equal>::find(const key_type& key) const
+    -> const_iterator {
+  const std::uint64_t hash = hash_(key);
+  auto index = function_.index(hash);
+  if (index == function_.npos) {
+    index = function_.find_remaining(hash, [&](size_type i) {
+      return key_equal{}(entries_[i].first, key);
+    });
+    return index == function_.npos ? end() : begin() + index;
+  }
+  return key_equal{}(entries_[index].first, key) ? begin() + index : end();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+auto frozen_hash_map<Key, T, Hash, Key_equal>::memory_usage() const
+    -> hash_map_memory {
+  hash_map_memory result{};
+  result.table_bytes =
+      entries_.capacity() * sizeof(value_type) + function_.memory_bytes();
+  result.padding_bytes =
+      entries_.size() * (sizeof(value_type) - sizeof(Key) - sizeof(T));
+  if constexpr (heap_size<key_type>::enabled) {
+    for (const auto& entry : entries_)
+      result.key_heap_bytes += heap_size<key_type>{}(entry.first);
+  }
+  return result;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void frozen_hash_map<Key, T, Hash, Key_equal>::save(std::ostream& out) const {
+  using detail::serializer;
+  detail::snapshot_writer writer{out};
+  detail::snapshot_header header{};
+  std::memcpy(header.magic, header.magic_value, sizeof(header.magic));
+  header.version = header.current_version;
+  // The indices of the entries are no slots of a hash_map.
+  header.flags = 0;
+  header.hasher_id = detail::hasher_id(hash_);
+  header.probing_id = detail::type_id<frozen_hash_map>();
+  header.key_id = detail::type_id<key_type>();
+  header.value_id = detail::type_id<mapped_type>();
+  header.capacity = entries_.size();
+  header.size = entries_.size();
+  writer.write(&header, sizeof(header));
+
+  for (std::uint64_t i = 0; i < entries_.size(); ++i) {
+    const std::uint64_t hash = hash_(entries_[i].first);
+    writer.write(&i, sizeof(i));
+    writer.write(&hash, sizeof(hash));
+    serializer<key_type>::write(writer, entries_[i].first);
+    serializer<mapped_type>::write(writer, entries_[i].second);
+  }
+  writer.finish();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void frozen_hash_map<Key, T, Hash, Key_equal>::load(std::istream& in) {
+  using detail::serializer;
+  detail::snapshot_reader reader{in};
+  detail::snapshot_header header;
+  reader.read(&header, sizeof(header));
+  if (std::memcmp(header.magic, header.magic_value, sizeof(header.magic)) ||
+      header.version != header.current_version)
+    throw std::runtime_error{"The stream contains no compatible snapshot!"};
+  if (header.key_id != detail::type_id<key_type>() ||
+      header.value_id != detail::type_id<mapped_type>())
+    throw std::runtime_error{"The snapshot has other key or value types!"};
+
+  const auto same_hash = header.hasher_id == detail::hasher_id(hash_);
+  std::vector<value_type> entries{};
+  std::vector<std::uint64_t> hashes{};
+  for (std::uint64_t n = 0; n < header.size; ++n) {
+    std::uint64_t index = 0;
+    std::uint64_t hash = 0;
+    reader.read(&index, sizeof(index));
+    reader.read(&hash, sizeof(hash));
+    auto key = serializer<key_type>::read(reader);
+    auto value = serializer<mapped_type>::read(reader);
+    hashes.push_back(same_hash ? hash : std::uint64_t{hash_(key)});
+    entries.emplace_back(std::move(key), std::move(value));
+  }
+  reader.finish();
+
+  frozen_hash_map map{hash_};
+  try {
+    map.build(std::move(entries), hashes);
+  } catch (const std::invalid_argument&) {
+    throw std::runtime_error{"The snapshot is corrupt!"};
+  }
+  *this = std::move(map);
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_FROZEN_HASH_MAP_H_
@@ -0,0 +1,405 @@
+#ifndef STROUPO_HASH_MAP_HASH_H_
+#define STROUPO_HASH_MAP_HASH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace stroupo {
+
+namespace detail {
+
+// The finalizer of MurmurHash3. Every bit of the input affects every bit of
+// the result.
+constexpr std::uint64_t murmur_mix(std::uint64_t x) noexcept {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+// One multiplication moves the entropy into the high bits and one shift
+// brings it back to the low bits. Cheaper but weaker than murmur_mix.
+constexpr std::uint64_t multiply_xorshift(std::uint64_t x) noexcept {
+  x *= 0x9e3779b97f4a7c15ull;
+  return x ^ (x >> 32);
+}
+
+// Replaces a and b by the low and the high half of their 128-bit product.
+inline void multiply_128(std::uint64_t& a, std::uint64_t& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  const auto product = static_cast<unsigned __int128>(a) * b;
+  a = static_cast<std::uint64_t>(product);
+  b = static_cast<std::uint64_t>(product >> 64);
+#else
+  const auto a_low = a & 0xffffffffull, a_high = a >> 32;
+  const auto b_low = b & 0xffffffffull, b_high = b >> 32;
+  const auto low = a_low * b_low, middle1 = a_high * b_low;
+  const auto middle2 = a_low * b_high, high = a_high * b_high;
+  const auto carry =
+      ((low >> 32) + (middle1 & 0xffffffffull) + (middle2 & 0xffffffffull)) >>
+      32;
+  a = low + (middle1 << 32) + (middle2 << 32);
+  b = high + (middle1 >> 32) + (middle2 >> 32) + carry;
+#endif
+}
+
+// Folds the 128-bit product of a and b into 64 bits.
+inline std::uint64_t multiply_fold(std::uint64_t a, std::uint64_t b) noexcept {
+  multiply_128(a, b);
+  return a ^ b;
+}
+
+inline std::uint64_t read_64(const unsigned char* p) noexcept {
+  std::uint64_t result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline std::uint64_t read_32(const unsigned char* p) noexcept {
+  std::uint32_t result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+// A string hash in the style of wyhash. Every multiplication consumes 16 bytes
+// and long strings are processed in three independent lanes.
+inline std::uint64_t wyhash_bytes(const void* data, std::size_t size,
+                                  std::uint64_t seed) noexcept {
+  constexpr std::uint64_t secret[4] = {
+      0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+      0x589965cc75374cc3ull};
+  const auto* p = static_cast<const unsigned char*>(data);
+  seed ^= multiply_fold(seed ^ secret[0], secret[1]);
+  std::uint64_t a = 0;
+  std::uint64_t b = 0;
+  if (size <= 16) {
+    if (size >= 4) {
+      // Two overlapping reads at each end cover all bytes.
+      const auto offset = (size >> 3) << 2;
+      a = (read_32(p) << 32) | read_32(p + offset);
+      b = (read_32(p + size - 4) << 32) | read_32(p + size - 4 - offset);
+    } else if (size > 0) {
+      a = (std::uint64_t{p[0]} << 16) | (std::uint64_t{p[size >> 1]} << 8) |
+          p[size - 1];
+    }
+  } else {
+    auto rest = size;
+    if (rest > 48) {
+      auto seed1 = seed;
+      auto seed2 = seed;
+      for (; rest > 48; rest -= 48, p += 48) {
+        seed = multiply_fold(read_64(p) ^ secret[1], read_64(p + 8) ^ seed);
+        seed1 = multiply_fold(read_64(p + 16) ^ secret[2],
+                              read_64(p + 24) ^ seed1);
+        seed2 = multiply_fold(read_64(p + 32) ^ secret[3],
+                              read_64(p + 40) ^ seed2);
+      }
+      seed ^= seed1 ^ seed2;
+    }
+    for (; rest > 16; rest -= 16, p += 16)
+      seed = multiply_fold(read_64(p) ^ secret[1], read_64(p + 8) ^ seed);
+    // The last 16 bytes may overlap with bytes which were already consumed.
+    a = read_64(p + rest - 16);
+    b = read_64(p + rest - 8);
+  }
+  a ^= secret[1];
+  b ^= seed;
+  multiply_128(a, b);
+  return multiply_fold(a ^ secret[0] ^ size, b ^ secret[1]);
+}
+
+// The lookup table of the reflected CRC32C polynomial.
+struct crc32c_table {
+  std::uint32_t values[256];
+};
+
+constexpr crc32c_table make_crc32c_table() noexcept {
+  crc32c_table table{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    auto crc = i;
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78u : 0u);
+    table.values[i] = crc;
+  }
+  return table;
+}
+
+inline constexpr crc32c_table crc32c_lookup = make_crc32c_table();
+
+// Updates a CRC32C one byte at a time. Used if there is no CRC instruction.
+inline std::uint32_t crc32c_software(std::uint32_t crc, const void* data,
+                                     std::size_t size) noexcept {
+  const auto* p = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i)
+    crc = crc32c_lookup.values[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+// Updates a CRC32C with the instructions of SSE 4.2 or ARMv8 if they are
+// enabled at compile time. The result does not depend on the path.
+inline std::uint32_t crc32c(std::uint32_t crc, const void* data,
+                            std::size_t size) noexcept {
+#if defined(__SSE4_2__) && defined(__x86_64__)
+  const auto* p = static_cast<const unsigned char*>(data);
+  std::uint64_t wide = crc;
+  for (; size >= 8; size -= 8, p += 8) wide = _mm_crc32_u64(wide, read_64(p));
+  crc = static_cast<std::uint32_t>(wide);
+  for (; size > 0; --size, ++p) crc = _mm_crc32_u8(crc, *p);
+  return crc;
+#elif defined(__ARM_FEATURE_CRC32)
+  const auto* p = static_cast<const unsigned char*>(data);
+  for (; size >= 8; size -= 8, p += 8) crc = __crc32cd(crc, read_64(p));
+  for (; size > 0; --size, ++p) crc = __crc32cb(crc, *p);
+  return crc;
+#else
+  return crc32c_software(crc, data, size);
+#endif
+}
+
+// A random seed which is drawn once per process.
+inline std::uint64_t process_seed() {
+  static const std::uint64_t seed = [] {
+    std::random_device device{};
+    return (std::uint64_t{device()} << 32) ^ device();
+  }();
+  return seed;
+}
+
+// Another seed for every call. The seed of the process is mixed with a
+// counter because std::random_device may be slow.
+inline std::uint64_t instance_seed() {
+  static std::atomic<std::uint64_t> counter{0};
+  const auto n = counter.fetch_add(1, std::memory_order_relaxed);
+  return murmur_mix(process_seed() ^ murmur_mix(n));
+}
+
+template <typename K>
+constexpr bool is_integer_key_v =
+    std::is_integral_v<K> || std::is_enum_v<K> || std::is_pointer_v<K>;
+
+template <typename K>
+using enable_if_integer_key_t = std::enable_if_t<is_integer_key_v<K>>;
+
+template <typename K>
+constexpr std::uint64_t integer_bits(K key) noexcept {
+  if constexpr (std::is_pointer_v<K>)
+    return reinterpret_cast<std::uintptr_t>(key);
+  else
+    return static_cast<std::uint64_t>(key);
+}
+
+}  // namespace detail
+
+// Hashers for integers, enumerations and pointers. Their seed is xored into
+// the key before it is mixed.
+
+// Uses the finalizer of MurmurHash3. Sequential keys are spread over all bits.
+class murmur_hash {
+ public:
+  murmur_hash() = default;
+  explicit constexpr murmur_hash(std::uint64_t seed) noexcept : seed_{seed} {}
+
+  template <typename K, typename = detail::enable_if_integer_key_t<K>>
+  constexpr std::size_t operator()(K key) const noexcept {
+    return detail::murmur_mix(detail::integer_bits(key) ^ seed_);
+  }
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  std::uint64_t seed_{0};
+};
+
+// Uses one multiplication and one shift. Good enough for most integer keys
+// together with the Fibonacci reduction.
+class multiply_xorshift_hash {
+ public:
+  multiply_xorshift_hash() = default;
+  explicit constexpr multiply_xorshift_hash(std::uint64_t seed) noexcept
+      : seed_{seed} {}
+
+  template <typename K, typename = detail::enable_if_integer_key_t<K>>
+  constexpr std::size_t operator()(K key) const noexcept {
+    return detail::multiply_xorshift(detail::integer_bits(key) ^ seed_);
+  }
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  std::uint64_t seed_{0};
+};
+
+// A transparent string hasher in the style of wyhash. Much faster than
+// std::hash for long strings. Lookups with std::string_view and C strings do
+// not construct a temporary std::string.
+class wyhash {
+ public:
+  using is_transparent = void;
+
+  wyhash() = default;
+  explicit constexpr wyhash(std::uint64_t seed) noexcept : seed_{seed} {}
+
+  std::size_t operator()(std::string_view key) const noexcept {
+    return detail::wyhash_bytes(key.data(), key.size(), seed_);
+  }
+  std::size_t operator()(const std::string& key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  std::size_t operator()(const char* key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  std::uint64_t seed_{0};
+};
+
+// Hashes integers and strings with CRC32C which is a single instruction per
+// eight bytes on CPUs with SSE 4.2 or ARMv8. The CRC is linear. Hence, keys of
+// equal length whose difference has a zero checksum would collide for every
+// initial value. Every word is therefore XORed with the seed and folded by a
+// multiplication with a fixed constant before it enters the checksum. The fold
+// is not linear. The 32-bit checksum is spread over all bits by a keyed
+// multiplication.
+class crc32c_hash {
+ public:
+  using is_transparent = void;
+
+  crc32c_hash() = default;
+  explicit constexpr crc32c_hash(std::uint64_t seed) noexcept : seed_{seed} {}
+
+  template <typename K, typename = detail::enable_if_integer_key_t<K>>
+  std::size_t operator()(K key) const noexcept {
+    const auto crc = update(static_cast<std::uint32_t>(seed_),
+                            detail::integer_bits(key));
+    return spread(crc, sizeof(K));
+  }
+  std::size_t operator()(std::string_view key) const noexcept {
+    const auto* p = reinterpret_cast<const unsigned char*>(key.data());
+    auto crc = static_cast<std::uint32_t>(seed_);
+    auto rest = key.size();
+    for (; rest >= 8; rest -= 8, p += 8) crc = update(crc, detail::read_64(p));
+    if (rest > 0) {
+      // The size is part of the result. Hence, padding with zeros is fine.
+      std::uint64_t tail = 0;
+      std::memcpy(&tail, p, rest);
+      crc = update(crc, tail);
+    }
+    return spread(crc, key.size());
+  }
+  std::size_t operator()(const std::string& key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  std::size_t operator()(const char* key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  std::uint32_t update(std::uint32_t crc, std::uint64_t word) const noexcept {
+    word = detail::multiply_fold(word ^ seed_, 0x9e3779b97f4a7c15ull);
+    return detail::crc32c(crc, &word, sizeof(word));
+  }
+  std::size_t spread(std::uint32_t crc, std::size_t size) const noexcept {
+    return detail::multiply_fold(crc ^ seed_,
+                                 (seed_ >> 32) ^ size ^ 0xe7037ed1a0b428dbull);
+  }
+
+  std::uint64_t seed_{0};
+};
+
+// Hashes strings with FNV-1a, one byte at a time, and mixes the result by the
+// finalizer of MurmurHash3. It is much slower than wyhash for long strings but
+// can be evaluated in constant expressions, e.g. by static_hash_map.
+class fnv1a_hash {
+ public:
+  using is_transparent = void;
+
+  fnv1a_hash() = default;
+  explicit constexpr fnv1a_hash(std::uint64_t seed) noexcept : seed_{seed} {}
+
+  constexpr std::size_t operator()(std::string_view key) const noexcept {
+    std::uint64_t state = 0xcbf29ce484222325ull ^ seed_;
+    for (const auto c : key) {
+      state ^= static_cast<unsigned char>(c);
+      state *= 0x100000001b3ull;
+    }
+    return detail::murmur_mix(state);
+  }
+  std::size_t operator()(const std::string& key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  constexpr std::size_t operator()(const char* key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  std::uint64_t seed_{0};
+};
+
+// The default choice of the library. Integers, enumerations and pointers are
+// hashed by murmur_hash, strings by wyhash. For all other keys, the result of
+// std::hash is mixed by the finalizer of MurmurHash3 because many
+// implementations of std::hash are the identity.
+template <typename Key, typename = void>
+class hash {
+ public:
+  hash() = default;
+  explicit constexpr hash(std::uint64_t seed) noexcept : seed_{seed} {}
+
+  std::size_t operator()(const Key& key) const
+      noexcept(noexcept(std::hash<Key>{}(key))) {
+    return detail::murmur_mix(std::hash<Key>{}(key) ^ seed_);
+  }
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  std::uint64_t seed_{0};
+};
+
+template <typename Key>
+class hash<Key, std::enable_if_t<detail::is_integer_key_v<Key>>>
+    : public murmur_hash {
+ public:
+  using murmur_hash::murmur_hash;
+};
+
+template <>
+class hash<std::string> : public wyhash {
+ public:
+  using wyhash::wyhash;
+};
+
+template <>
+class hash<std::string_view> : public wyhash {
+ public:
+  using wyhash::wyhash;
+};
+
+// Seeds a hasher with a random seed. Attackers who do not know the seed
+// cannot craft keys which collide. Every instance gets another seed. The maps
+// keep the hasher they were constructed with, so that every map has its own
+// seed. Copies keep the seed.
+template <typename Hash>
+class randomly_seeded : public Hash {
+ public:
+  randomly_seeded() : Hash{detail::instance_seed()} {}
+};
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_HASH_H_
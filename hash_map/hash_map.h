@@ -1,29 +1,115 @@
 #ifndef STROUPO_HASH_MAP_H_
 #define STROUPO_HASH_MAP_H_
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
 #include <vector>
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+
+#include <hash_map/bitmap_layout.h>
+#include <hash_map/control_byte_layout.h>
+#include <hash_map/execution.h>
+#include <hash_map/memory.h>
+#include <hash_map/node_layout.h>
+#include <hash_map/policy.h>
+#include <hash_map/reduction.h>
+#include <hash_map/sentinel_layout.h>
+#include <hash_map/serialization.h>
+#include <hash_map/soa_layout.h>
+#include <hash_map/stats.h>
 
 namespace stroupo {
 
+namespace detail {
+
+template <typename T, typename = void>
+struct is_transparent : std::false_type {};
+
+template <typename T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>>
+    : std::true_type {};
+
+// The key type K is only used to make the condition dependent. Otherwise, the
+// overloads using it could not be disabled through SFINAE.
+template <typename K, typename Hash, typename Key_equal>
+using enable_if_transparent_t =
+    std::enable_if_t<is_transparent<Hash>::value &&
+                     is_transparent<Key_equal>::value &&
+                     !std::is_void_v<K>>;
+
+// Stores the hasher of a map. Empty hashers are a base class and take no
+// space.
+template <typename Hash,
+          bool = std::is_empty_v<Hash> && !std::is_final_v<Hash>>
+class hasher_storage : private Hash {
+ public:
+  hasher_storage() = default;
+  explicit hasher_storage(const Hash& hash) : Hash(hash) {}
+  const Hash& hash_ref() const noexcept { return *this; }
+};
+
+template <typename Hash>
+class hasher_storage<Hash, false> {
+ public:
+  hasher_storage() = default;
+  explicit hasher_storage(const Hash& hash) : hash_(hash) {}
+  const Hash& hash_ref() const noexcept { return hash_; }
+
+ private:
+  Hash hash_{};
+};
+
+// Gives iterators whose reference is a proxy object an operator->.
+template <typename Reference>
+struct arrow_proxy {
+  Reference reference;
+  const Reference* operator->() const { return &reference; }
+};
+
+}  // namespace detail
+
 template <typename Key, typename T, typename Hash = std::hash<Key>,
           typename Key_equal = std::equal_to<Key>,
-          typename Allocator = std::allocator<std::pair<const Key, T>>>
-class hash_map {
+          typename Allocator = std::allocator<std::pair<const Key, T>>,
+          typename... Policies>
+class hash_map : private detail::hasher_storage<Hash> {
+  static_assert((is_policy_v<Policies> && ...),
+                "Every given policy needs a policy category!");
+
   // Internal Member Types
-  struct node;
   template <bool Constant>
   class iterator_t;
 
  public:
   // Non-standard Member Types
-  using container = std::vector<node>;
+  using erasure_policy =
+      select_policy_t<erasure_policy_tag, backward_shift_erasure, Policies...>;
+  using hash_storage_policy =
+      select_policy_t<hash_storage_policy_tag, recomputed_hash, Policies...>;
+  using layout_policy =
+      select_policy_t<layout_policy_tag, node_layout, Policies...>;
+  using probing_policy =
+      select_policy_t<probing_policy_tag, linear_probing, Policies...>;
+  using reduction_policy =
+      select_policy_t<reduction_policy_tag, modulo_reduction, Policies...>;
+  using rehash_policy =
+      select_policy_t<rehash_policy_tag, full_rehash, Policies...>;
+  using stats_policy = select_policy_t<stats_policy_tag, no_stats, Policies...>;
+  using container = typename layout_policy::template storage<
+      Key, T, Allocator, hash_storage_policy::stored>;
   using real_type = float;
   // Standard Member Types
   using key_type = Key;
@@ -34,18 +120,51 @@ class hash_map {
   using hasher = Hash;
   using key_equal = Key_equal;
   using allocator_type = Allocator;
-  using reference = value_type&;
-  using const_reference = const value_type&;
+  // References to value_type unless the layout stores keys and values apart.
+  using reference = decltype(std::declval<container&>()[size_type{}]);
+  using const_reference =
+      decltype(std::declval<const container&>()[size_type{}]);
   using pointer = typename std::allocator_traits<allocator_type>::pointer;
   using const_pointer =
       typename std::allocator_traits<allocator_type>::const_pointer;
   using iterator = iterator_t<false>;
   using const_iterator = iterator_t<true>;
 
+ private:
+  static constexpr bool robin_hood =
+      std::is_same_v<probing_policy, robin_hood_probing>;
+  static_assert(!robin_hood || container::max_distance > 0,
+                "Robin Hood probing needs a layout storing probe distances!");
+  static_assert(!robin_hood ||
+                    std::is_same_v<erasure_policy, backward_shift_erasure>,
+                "Robin Hood probing does not support tombstones!");
+  static constexpr bool incremental = rehash_policy::migration_step > 0;
+
+  // Lookups with other key types than key_type are only allowed if the hasher
+  // and key_equal are transparent.
+  template <typename K>
+  using transparent_key_t = detail::enable_if_transparent_t<K, Hash, Key_equal>;
+
  public:
   // Constructors, Destructors and Assignments
-  hash_map();
-  hash_map(std::initializer_list<value_type> list);
+  hash_map() : hash_map{allocator_type{}} {}
+  explicit hash_map(const allocator_type& alloc)
+      : hash_map{hasher{}, alloc} {}
+  // Every call hashes with a copy of the given hasher. Hence, its seed can be
+  // chosen per map.
+  explicit hash_map(const hasher& hash,
+                    const allocator_type& alloc = allocator_type{});
+  hash_map(std::initializer_list<value_type> list,
+           const allocator_type& alloc = allocator_type{});
+  // Builds the map from a random access range of values on the given number of
+  // threads. Like insert, later values overwrite earlier ones of equal keys.
+  template <typename Random_access_iterator>
+  static hash_map build_from(Random_access_iterator first,
+                             Random_access_iterator last, size_type threads = 0,
+                             const allocator_type& alloc = allocator_type{});
+
+  allocator_type get_allocator() const { return table_.get_allocator(); }
+  hasher hash_function() const { return hash_ref(); }
 
   // Capacity
   bool empty() const { return load_ == 0; }
@@ -59,76 +178,271 @@ class hash_map {
   auto end() noexcept;
   auto end() const noexcept;
 
+  // Visitors
+  // Calls f(key, value) for every entry. The loop over the slots is not
+  // interrupted by iterator comparisons and can be optimized as a whole.
+  template <typename Function>
+  void for_each(Function f);
+  template <typename Function>
+  void for_each(Function f) const;
+  // Calls f(keys, values, count) with arrays of pointers to up to
+  // visit_batch_size entries. The entries are not copied. Hence, move-only
+  // types are fine. Visitors loop over the arrays without checking for empty
+  // slots.
+  static constexpr size_type visit_batch_size = 64;
+  template <typename Function>
+  void for_each_batch(Function f) const;
+
   // Modifiers
+  // Existing keys get the new value assigned.
   void insert(const value_type& value);
+  void insert(value_type&& value);
   template <typename Iterator>
   void insert(Iterator first, Iterator last);
   template <typename Key_iterator, typename T_iterator>
   void insert(Key_iterator keys_first, Key_iterator keys_last,
               T_iterator first);
-  auto erase(const key_type& key);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj);
+  size_type erase(const key_type& key) { return erase_key(key); }
+  template <typename K, typename = transparent_key_t<K>>
+  size_type erase(const K& key) {
+    return erase_key(key);
+  }
 
   // Lookup
   mapped_type& operator[](const key_type& key);
-  mapped_type& at(const key_type& key);
-  const mapped_type& at(const key_type& key) const;
-  iterator find(const key_type& key);
-  const_iterator find(const key_type& key) const;
+  mapped_type& operator[](key_type&& key);
+  mapped_type& at(const key_type& key) {
+    return mutable_iterator(checked_find(key))->second;
+  }
+  const mapped_type& at(const key_type& key) const {
+    return checked_find(key)->second;
+  }
+  template <typename K, typename = transparent_key_t<K>>
+  mapped_type& at(const K& key) {
+    return mutable_iterator(checked_find(key))->second;
+  }
+  template <typename K, typename = transparent_key_t<K>>
+  const mapped_type& at(const K& key) const {
+    return checked_find(key)->second;
+  }
+  iterator find(const key_type& key) {
+    return mutable_iterator(lookup(key, hash_ref()(key)));
+  }
+  const_iterator find(const key_type& key) const {
+    return lookup(key, hash_ref()(key));
+  }
+  template <typename K, typename = transparent_key_t<K>>
+  iterator find(const K& key) {
+    return mutable_iterator(lookup(key, hash_ref()(key)));
+  }
+  template <typename K, typename = transparent_key_t<K>>
+  const_iterator find(const K& key) const {
+    return lookup(key, hash_ref()(key));
+  }
+  bool contains(const key_type& key) const { return find(key) != end(); }
+  template <typename K, typename = transparent_key_t<K>>
+  bool contains(const K& key) const {
+    return find(key) != end();
+  }
+  size_type count(const key_type& key) const { return contains(key); }
+  template <typename K, typename = transparent_key_t<K>>
+  size_type count(const K& key) const {
+    return contains(key);
+  }
+
+  // Batched Lookup
+  // Every key of the range [first, last) is looked up and the result is
+  // written to out. The keys are processed in blocks of batch_size. For each
+  // block, the hash values are computed and the home slots are prefetched
+  // before the first key is probed. Hence, the cache misses overlap.
+  static constexpr size_type batch_size = 16;
+  template <typename Key_iterator, typename Output_iterator>
+  Output_iterator find_batch(Key_iterator first, Key_iterator last,
+                             Output_iterator out);
+  template <typename Key_iterator, typename Output_iterator>
+  Output_iterator find_batch(Key_iterator first, Key_iterator last,
+                             Output_iterator out) const;
+  template <typename Key_iterator, typename Output_iterator>
+  Output_iterator contains_batch(Key_iterator first, Key_iterator last,
+                                 Output_iterator out) const;
 
   // Hash Policy
   auto load_factor() const;
   auto max_load_factor() const { return max_load_factor_; }
   void max_load_factor(real_type ml) { max_load_factor_ = ml; }
   void rehash(size_type count);
+  void rehash(size_type count, execution::sequenced_policy) { rehash(count); }
+  void rehash(size_type count, execution::parallel_policy policy);
   void reserve(size_type count);
+  // Returns whether an incremental rehash is still migrating entries.
+  bool rehashing() const noexcept;
+
+  // Statistics
+  // The counters are only collected with the collect_stats policy.
+  hash_map_stats stats() const;
+  void reset_stats() { stats_.reset(); }
+  // Writes the histograms of the probe distances of all entries and of the
+  // lengths of all clusters of full slots as tab-separated lines.
+  void dump_distribution(std::ostream& out) const;
+  // The heap bytes of the keys are counted in a pass over all entries if
+  // heap_size is specialized for key_type.
+  hash_map_memory memory_usage() const;
+
+  // Serialization
+  // Writes a snapshot of the map in one sequential pass over its slots. Keys
+  // and values have to be trivially copyable or strings.
+  void save(std::ostream& out) const;
+  // Replaces the content by a snapshot. If it was written by a map with the
+  // same hasher, probing and reduction, the slots are restored at their
+  // indices. Otherwise, the entries are reinserted. Throws std::runtime_error
+  // for corrupt snapshots and leaves the map unchanged.
+  void load(std::istream& in);
 
  private:
+  // The old table and its reduction during an incremental rehash.
+  struct migration_state {
+    std::optional<container> table{};
+    reduction_policy reduction{};
+    // The number of entries which were not migrated yet.
+    size_type load{0};
+    // The next slot of the old table which will be migrated.
+    size_type index{0};
+    // The table of the next migration. Its memory is reserved shortly before
+    // the table has to grow and its slots are initialized in steps.
+    // Otherwise, the insertion which starts the migration would initialize
+    // the whole table.
+    std::optional<container> next{};
+    size_type next_capacity{0};
+  };
+  struct no_migration_state {};
+
+  // An entry of a parallel bulk insertion. The item is its index in the source.
+  struct bulk_entry {
+    size_type home;
+    std::size_t hash;
+    size_type item;
+  };
+  // The sources of parallel bulk insertions.
+  struct table_source;
+  template <typename Iterator>
+  struct range_source;
+
   // Internal Member Functions
-  auto node_index(const key_type& key) const;
-  const node* first_node() const;
-  const node* last_node() const;
+  using detail::hasher_storage<Hash>::hash_ref;
+  size_type home_index(std::size_t hash) const;
+  size_type next_index(size_type index) const;
+  size_type prev_index(size_type index) const;
+  size_type wrap_index(size_type index) const;
+  size_type distance(size_type home, size_type index) const;
+  template <typename Table, typename Function>
+  static void for_each_slot(Table& table, Function& f);
+  template <typename K>
+  std::pair<size_type, bool> probe(const K& key, std::size_t hash) const {
+    return probe(table_, reduction_, key, hash);
+  }
+  template <typename K>
+  std::pair<size_type, bool> probe(const container& table,
+                                   const reduction_policy& reduction,
+                                   const K& key, std::size_t hash) const;
+  template <typename K>
+  static bool matches(const container& table, size_type index, const K& key,
+                      std::size_t hash);
+  std::size_t slot_hash(const container& table, size_type index) const;
+  template <typename K>
+  const_iterator lookup(const K& key, std::size_t hash) const;
+  template <typename K>
+  const_iterator checked_find(const K& key) const;
+  iterator mutable_iterator(const_iterator it);
+  template <typename Key_iterator, typename Function>
+  void find_iterators(Key_iterator first, Key_iterator last,
+                      Function f) const;
+  template <typename K>
+  size_type erase_key(const K& key);
+  size_type erase_index(size_type index);
+  size_type vacant_index(std::size_t hash) const;
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace_key(K&& key, Args&&... args);
+  template <typename K, typename M>
+  std::pair<iterator, bool> insert_or_assign_key(K&& key, M&& obj);
+  template <typename K, typename V>
+  size_type insert_vacant(size_type index, std::size_t hash, K&& key,
+                          V&& value);
+  template <typename K, typename V>
+  bool place(size_type index, std::size_t hash, K&& key, V&& value);
+  bool grow();
+  void backward_shift(size_type index);
+  // The migration state is passed explicitly because the member only has
+  // this type if the rehash policy is incremental.
+  void start_migration(migration_state& migration, size_type count);
+  void prepare_table(migration_state& migration);
+  template <typename K>
+  void prepare_mutation(migration_state& migration, const K& key,
+                        std::size_t hash);
+  void migrate(migration_state& migration, size_type slots);
+  size_type migrate_cluster(migration_state& migration, size_type index);
+  template <typename Source>
+  std::vector<bulk_entry> fill_regions(const Source& source, size_type threads);
+  template <typename Source>
+  std::pair<size_type, bool> probe_region(const Source& source,
+                                          const bulk_entry& entry,
+                                          size_type last);
 
  private:
   // Internal Member Variables
-  real_type max_load_factor_{0.5};
+  real_type max_load_factor_{probing_policy::max_load_factor};
   size_type load_{0};
+  size_type tombstones_{0};
   container table_;
+  reduction_policy reduction_;
+  std::conditional_t<incremental, migration_state, no_migration_state>
+      migration_{};
+  std::conditional_t<stats_policy::enabled, detail::stats_counters,
+                     detail::no_stats_counters>
+      stats_{};
 };
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-struct hash_map<Key, T, Hash, Key_equal, Allocator>::node {
-  node() = default;
-  node(const key_type& k, const mapped_type& v)
-      : key{k}, value{v}, empty{false} {}
-  node(const std::pair<key_type, mapped_type>& v) : node{v.first, v.second} {}
-
-  // Member Variables
-  // The order should no be changed.
-  // It is used for an reinterpret_cast to value_type.
-  key_type key{};
-  mapped_type value{};
-  bool empty{true};
-};
-
-template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
+          typename Allocator, typename... Policies>
 template <bool Constant>
-class hash_map<Key, T, Hash, Key_equal, Allocator>::iterator_t {
+class hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::iterator_t {
  public:
   // Standard Member Types
-  using iterator_category = std::forward_iterator_tag;
   using value_type = hash_map::value_type;
   using difference_type = hash_map::difference_type;
-  using reference =
-      std::conditional_t<Constant, const value_type&, value_type&>;
-  using pointer = std::conditional_t<Constant, const value_type*, value_type*>;
+  using reference = std::conditional_t<Constant, hash_map::const_reference,
+                                       hash_map::reference>;
+  // Proxy references can only be used by input iterators.
+  using iterator_category =
+      std::conditional_t<std::is_reference_v<reference>,
+                         std::forward_iterator_tag, std::input_iterator_tag>;
+  using pointer =
+      std::conditional_t<std::is_reference_v<reference>,
+                         std::remove_reference_t<reference>*,
+                         detail::arrow_proxy<reference>>;
   // Non-standard Member Types
-  using node_pointer = std::conditional_t<Constant, const node*, node*>;
+  using container_pointer =
+      std::conditional_t<Constant, const container*, container*>;
 
   // Constructors, Destructors and Assignments
   // iterator_t() = default; // There should be no default constructor.
-  iterator_t(node_pointer n) : node_{n} {}
+  iterator_t(container_pointer table, size_type index)
+      : table_{table}, index_{index} {}
+  // During an incremental rehash, the iteration continues with the next table
+  // after the end of the first one is reached.
+  iterator_t(container_pointer table, container_pointer next, size_type index)
+      : table_{table}, next_{next}, index_{index} {
+    skip_to_next_table();
+  }
   iterator_t(const iterator_t& it) = default;
   iterator_t& operator=(const iterator_t& it) = default;
   iterator_t(iterator_t&& it) = default;
@@ -138,188 +452,1091 @@ class hash_map<Key, T, Hash, Key_equal, Allocator>::iterator_t {
   // Member Functions
   iterator_t& operator++();
   iterator_t operator++(int);
-  reference operator*() const { return *reinterpret_cast<pointer>(node_); }
-  pointer operator->() const { return reinterpret_cast<pointer>(node_); }
-  bool operator==(iterator_t it) const { return node_ == it.node_; }
+  reference operator*() const { return (*table_)[index_]; }
+  pointer operator->() const {
+    if constexpr (std::is_reference_v<reference>)
+      return &(*table_)[index_];
+    else
+      return pointer{(*table_)[index_]};
+  }
+  bool operator==(iterator_t it) const {
+    return table_ == it.table_ && index_ == it.index_;
+  }
   bool operator!=(iterator_t it) const { return !(*this == it); }
 
+ private:
+  friend class hash_map;
+
+  void skip_to_next_table() {
+    if (index_ != table_->size() || !next_) return;
+    table_ = std::exchange(next_, nullptr);
+    index_ = table_->next_full(0);
+  }
+
  private:
   // Internal Member Variables
-  node_pointer node_;
+  container_pointer table_;
+  container_pointer next_{nullptr};
+  size_type index_;
 };
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
+          typename Allocator, typename... Policies>
 template <bool Constant>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::iterator_t<Constant>::
-operator++() -> iterator_t& {
-  while ((++node_)->empty)
-    ;
+auto hash_map<Key, T, Hash, Key_equal, Allocator,
+              Policies...>::iterator_t<Constant>::operator++() -> iterator_t& {
+  index_ = table_->next_full(index_ + 1);
+  skip_to_next_table();
   return *this;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
+          typename Allocator, typename... Policies>
 template <bool Constant>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::iterator_t<Constant>::
-operator++(int n) -> iterator_t {
+auto hash_map<Key, T, Hash, Key_equal, Allocator,
+              Policies...>::iterator_t<Constant>::operator++(int n)
+    -> iterator_t {
   auto ip = *this;
   ++(*this);
   return ip;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-hash_map<Key, T, Hash, Key_equal, Allocator>::hash_map() : table_(2) {
-  table_.reserve(3);
-  table_[2].empty = false;
-}
+          typename Allocator, typename... Policies>
+hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::hash_map(
+    const hasher& hash, const allocator_type& alloc)
+    : detail::hasher_storage<Hash>{hash},
+      table_(reduction_policy::capacity(
+                 std::max<size_type>(2, container::min_capacity)),
+             alloc),
+      reduction_{table_.size()} {}
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-hash_map<Key, T, Hash, Key_equal, Allocator>::hash_map(
-    std::initializer_list<value_type> list)
-    : hash_map{} {
+          typename Allocator, typename... Policies>
+hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::hash_map(
+    std::initializer_list<value_type> list, const allocator_type& alloc)
+    : hash_map{alloc} {
   reserve(list.size());
-  for (const auto& e : list) {
-    const auto index = node_index(e.first);
-    if (table_[index].empty) ++load_;
-    table_[index] = {e.first, e.second};
-  }
+  for (const auto& e : list) insert(e);
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::load_factor() const {
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::load_factor()
+    const {
   return static_cast<real_type>(load_) / table_.size();
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::first_node() const
-    -> const node* {
-  auto p = &table_[0];
-  while (p->empty) ++p;
-  return p;
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator,
+              Policies...>::begin() noexcept {
+  // Entries which are not migrated yet are visited first.
+  if constexpr (incremental) {
+    if (rehashing()) {
+      auto& old = *migration_.table;
+      return iterator{&old, &table_, old.next_full(0)};
+    }
+  }
+  return iterator{&table_, table_.next_full(0)};
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::begin()
+    const noexcept {
+  if constexpr (incremental) {
+    if (rehashing()) {
+      const auto& old = *migration_.table;
+      return const_iterator{&old, &table_, old.next_full(0)};
+    }
+  }
+  return const_iterator{&table_, table_.next_full(0)};
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::last_node() const
-    -> const node* {
-  return &table_[table_.size()];
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator,
+              Policies...>::end() noexcept {
+  return iterator{&table_, table_.size()};
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::begin() noexcept {
-  return iterator{const_cast<node*>(first_node())};
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::end()
+    const noexcept {
+  return const_iterator{&table_, table_.size()};
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::begin() const noexcept {
-  return const_iterator{first_node()};
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::home_index(
+    std::size_t hash) const -> size_type {
+  return reduction_.index(hash);
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::end() noexcept {
-  return iterator{const_cast<node*>(last_node())};
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::next_index(
+    size_type index) const -> size_type {
+  return reduction_.wrap(index + 1);
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::end() const noexcept {
-  return const_iterator{last_node()};
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::prev_index(
+    size_type index) const -> size_type {
+  return ((index == 0) ? table_.size() : index) - 1;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::node_index(
-    const key_type& key) const {
-  hasher hash{};
-  key_equal equal{};
-  size_type index = hash(key) % table_.size();
-  while (!table_[index].empty && !equal(key, table_[index].key))
-    index = (index + 1) % table_.size();
-  return index;
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::wrap_index(
+    size_type index) const -> size_type {
+  // Only used for offsets inside a group which is never larger than the table.
+  return reduction_.wrap(index);
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-void hash_map<Key, T, Hash, Key_equal, Allocator>::rehash(size_type count) {
-  container old_data(count);
-  old_data.reserve(count + 1);
-  old_data[count].empty = false;
-  table_.swap(old_data);
-  for (auto e : old_data)
-    if (!e.empty) table_[node_index(e.key)] = e;
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::distance(
+    size_type home, size_type index) const -> size_type {
+  return (home <= index) ? index - home : index + table_.size() - home;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-void hash_map<Key, T, Hash, Key_equal, Allocator>::reserve(size_type count) {
-  rehash(std::ceil(count / max_load_factor()));
+          typename Allocator, typename... Policies>
+template <typename Function>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::for_each(
+    Function f) {
+  if constexpr (incremental)
+    if (rehashing()) for_each_slot(*migration_.table, f);
+  for_each_slot(table_, f);
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-void hash_map<Key, T, Hash, Key_equal, Allocator>::insert(
-    const value_type& value) {
-  const auto index = node_index(value.first);
-  if (table_[index].empty) ++load_;
-  table_[index] = {value};
-  if (static_cast<real_type>(load_) / table_.size() >= max_load_factor())
+          typename Allocator, typename... Policies>
+template <typename Function>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::for_each(
+    Function f) const {
+  if constexpr (incremental)
+    if (rehashing()) for_each_slot(*migration_.table, f);
+  for_each_slot(table_, f);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::for_each_batch(
+    Function f) const {
+  const key_type* keys[visit_batch_size];
+  const mapped_type* values[visit_batch_size];
+  size_type count = 0;
+  const auto flush = [&] {
+    f(static_cast<const key_type* const*>(keys),
+      static_cast<const mapped_type* const*>(values), count);
+    count = 0;
+  };
+  for_each([&](const key_type& key, const mapped_type& value) {
+    keys[count] = &key;
+    values[count] = &value;
+    if (++count == visit_batch_size) flush();
+  });
+  if (count > 0) flush();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Table, typename Function>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::for_each_slot(
+    Table& table, Function& f) {
+  // Keys are only passed as constants, even from mutable tables.
+  const auto size = table.size();
+  for (auto i = table.next_full(0); i < size; i = table.next_full(i + 1))
+    f(std::as_const(table).key(i), table.value(i));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::probe(
+    const container& table, const reduction_policy& reduction, const K& key,
+    std::size_t hash) const -> std::pair<size_type, bool> {
+  // Returns the index of the key or the index where it has to be inserted.
+  // The table is only another one than table_ during an incremental rehash.
+  auto index = reduction.index(hash);
+  // The number of visited slots or groups. Only used by collect_stats.
+  size_type length = 1;
+  const auto result = [&](size_type i, bool found) {
+    stats_.record_probe(length, found);
+    return std::pair{i, found};
+  };
+  if constexpr (robin_hood) {
+    for (size_type d = 0;; ++d, ++length, index = reduction.wrap(index + 1)) {
+      // Keys behind a slot with a shorter probe distance have other homes.
+      if (table.empty(index) || table.distance(index) < d)
+        return result(index, false);
+      if (table.distance(index) == d && matches(table, index, key, hash))
+        return result(index, true);
+    }
+  } else if constexpr (container::group_width > 1) {
+    const auto fingerprint = container::fingerprint(hash);
+    auto vacant = table.size();
+    for (;; ++length, index = reduction.wrap(index + container::group_width)) {
+      const auto group = table.group(index);
+      const auto empty = group.match_empty();
+      // Keys behind the first empty slot belong to other probe sequences.
+      auto mask = group.match(fingerprint) & ((empty & (~empty + 1)) - 1);
+      for (; mask; mask &= mask - 1) {
+        const auto i =
+            reduction.wrap(index + detail::count_trailing_zeros(mask));
+        if (matches(table, i, key, hash)) return result(i, true);
+      }
+      if (vacant == table.size()) {
+        const auto free = group.match_empty_or_deleted();
+        if (free)
+          vacant = reduction.wrap(index + detail::count_trailing_zeros(free));
+      }
+      if (empty) return result(vacant, false);
+    }
+  } else {
+    // Deleted slots do not terminate the probe sequence.
+    auto vacant = table.size();
+    for (; !table.empty(index); ++length, index = reduction.wrap(index + 1)) {
+      if (!table.deleted(index)) {
+        if (matches(table, index, key, hash)) return result(index, true);
+      } else if (vacant == table.size()) {
+        vacant = index;
+      }
+    }
+    return result((vacant == table.size()) ? index : vacant, false);
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K>
+bool hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::matches(
+    const container& table, size_type index, const K& key, std::size_t hash) {
+  // Stored hash values are compared first because it is cheap.
+  if constexpr (hash_storage_policy::stored)
+    if (table.hash(index) != hash) return false;
+  return key_equal{}(key, table.key(index));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+std::size_t
+hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::slot_hash(
+    const container& table, size_type index) const {
+  if constexpr (hash_storage_policy::stored)
+    return table.hash(index);
+  else
+    return hash_ref()(table.key(index));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::lookup(
+    const K& key, std::size_t hash) const -> const_iterator {
+  // The index of a missing key equals the size of the table which is the
+  // index of the end iterator.
+  const auto [index, found] = probe(key, hash);
+  if constexpr (incremental) {
+    if (!found && rehashing()) {
+      const auto& old = *migration_.table;
+      const auto [i, f] = probe(old, migration_.reduction, key, hash);
+      if (f) return const_iterator{&old, &table_, i};
+    }
+  }
+  return const_iterator{&table_, found ? index : table_.size()};
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::checked_find(
+    const K& key) const -> const_iterator {
+  const auto it = lookup(key, hash_ref()(key));
+  if (it == end()) throw std::out_of_range{"The given key was not inserted!"};
+  return it;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    mutable_iterator(const_iterator it) -> iterator {
+  return iterator{const_cast<container*>(it.table_),
+                  const_cast<container*>(it.next_), it.index_};
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::vacant_index(
+    std::size_t hash) const -> size_type {
+  // Returns the index where a key which is not contained has to be inserted.
+  auto index = home_index(hash);
+  if constexpr (robin_hood) {
+    for (size_type d = 0; table_.full(index) && d <= table_.distance(index);
+         ++d)
+      index = next_index(index);
+    return index;
+  } else if constexpr (container::group_width > 1) {
+    for (;; index = wrap_index(index + container::group_width)) {
+      const auto mask = table_.group(index).match_empty_or_deleted();
+      if (mask) return wrap_index(index + detail::count_trailing_zeros(mask));
+    }
+  } else {
+    while (table_.full(index)) index = next_index(index);
+    return index;
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K, typename... Args>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::try_emplace_key(
+    K&& key, Args&&... args) -> std::pair<iterator, bool> {
+  // The mapped value is only constructed if the key is not contained.
+  const auto hash = hash_ref()(key);
+  if constexpr (incremental) prepare_mutation(migration_, key, hash);
+  const auto [index, found] = probe(key, hash);
+  if (found) return {iterator{&table_, index}, false};
+  const auto i = insert_vacant(index, hash, std::forward<K>(key),
+                               mapped_type(std::forward<Args>(args)...));
+  return {iterator{&table_, i}, true};
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K, typename M>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    insert_or_assign_key(K&& key, M&& obj) -> std::pair<iterator, bool> {
+  // obj is only moved from by try_emplace_key if the key was inserted.
+  auto result = try_emplace_key(std::forward<K>(key), std::forward<M>(obj));
+  if (!result.second) result.first->second = std::forward<M>(obj);
+  return result;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K, typename V>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::insert_vacant(
+    size_type index, std::size_t hash, K&& key, V&& value) -> size_type {
+  // index was invalidated through rehash
+  if (grow()) index = vacant_index(hash);
+  const auto reused = table_.deleted(index);
+  // The arguments are only moved from if the key could be placed.
+  while (!place(index, hash, std::forward<K>(key), std::forward<V>(value))) {
     rehash(2 * table_.size());
+    index = vacant_index(hash);
+  }
+  if (reused) --tombstones_;
+  ++load_;
+  return index;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::operator[](
-    const key_type& key) -> mapped_type& {
-  const auto index = node_index(key);
-  if (table_[index].empty) {
+          typename Allocator, typename... Policies>
+template <typename K, typename V>
+bool hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::place(
+    size_type index, std::size_t hash, K&& key, V&& value) {
+  if constexpr (robin_hood) {
+    // The entries in [index, last) are shifted one slot to the back.
+    const auto d = distance(home_index(hash), index);
+    if (d > container::max_distance) return false;
+    auto last = index;
+    for (; table_.full(last); last = next_index(last))
+      if (table_.distance(last) == container::max_distance) return false;
+    for (; last != index; last = prev_index(last)) {
+      table_.move(prev_index(last), last);
+      table_.distance(last, table_.distance(last) + 1);
+    }
+    table_.construct(index, hash, std::forward<K>(key), std::forward<V>(value));
+    table_.distance(index, d);
+  } else {
+    table_.construct(index, hash, std::forward<K>(key), std::forward<V>(value));
+  }
+  return true;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+bool hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::grow() {
+  const auto limit = table_.size() * max_load_factor();
+  if (load_ + tombstones_ + 1 < limit) return false;
+  // A table mostly filled with tombstones is only cleaned up.
+  const auto count =
+      (2 * (load_ + 1) < limit) ? table_.size() : 2 * table_.size();
+  if constexpr (incremental)
+    start_migration(migration_, count);
+  else
+    rehash(count);
+  return true;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::backward_shift(
+    size_type hole) {
+  if constexpr (robin_hood) {
+    // Every following entry which is not in its home slot moves one back.
+    for (auto index = next_index(hole);
+         table_.full(index) && table_.distance(index) > 0;
+         index = next_index(index)) {
+      table_.move(index, hole);
+      table_.distance(hole, table_.distance(hole) - 1);
+      hole = index;
+    }
+  } else {
+    for (auto index = next_index(hole); table_.full(index);
+         index = next_index(index)) {
+      // An entry may only fill the hole if its home index does not cyclically
+      // lie in (hole, index]. Otherwise it would become unreachable.
+      const auto home = home_index(slot_hash(table_, index));
+      if ((hole < index) ? (home <= hole || index < home)
+                         : (home <= hole && index < home)) {
+        table_.move(index, hole);
+        hole = index;
+      }
+    }
+  }
+  table_.destroy(hole);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::rehash(
+    size_type count) {
+  [[maybe_unused]] const auto timer = stats_.time_rehash();
+  if constexpr (incremental) {
+    if (rehashing()) migrate(migration_, std::numeric_limits<size_type>::max());
+    migration_.next.reset();
+  }
+  // There has to be at least one empty slot to terminate every probe sequence.
+  count = reduction_policy::capacity(
+      std::max({count, container::min_capacity, load_ + 1}));
+  container old_table(count, get_allocator());
+  table_.swap(old_table);
+  reduction_ = reduction_policy{count};
+  tombstones_ = 0;
+  for (auto i = old_table.next_full(0); i < old_table.size();
+       i = old_table.next_full(i + 1)) {
+    const auto hash = slot_hash(old_table, i);
+    // The old table is discarded. Hence, its entries are moved, not copied.
+    if (!place(vacant_index(hash), hash, std::move(old_table.key(i)),
+               std::move(old_table.value(i))))
+      throw std::overflow_error{"The probe distance exceeds its maximum!"};
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    start_migration(migration_state& migration, size_type count) {
+  // Only the start of the migration is timed. The rest is spread over the
+  // following modifications.
+  [[maybe_unused]] const auto timer = stats_.time_rehash();
+  // A pending migration is finished first. This only happens if the migration
+  // step is too small to migrate the old table before the new one is full.
+  if (migration.table)
+    migrate(migration, std::numeric_limits<size_type>::max());
+  count = reduction_policy::capacity(
+      std::max({count, container::min_capacity, load_ + 1}));
+  if (migration.next && migration.next_capacity == count) {
+    migration.next->resize(count);
+    migration.table = std::move(migration.next);
+  } else {
+    migration.table.emplace(count, get_allocator());
+  }
+  migration.next.reset();
+  auto& old = *migration.table;
+  table_.swap(old);
+  migration.reduction = std::exchange(reduction_, reduction_policy{count});
+  migration.load = load_;
+  tombstones_ = 0;
+  // The migration starts behind an empty slot. Hence, it starts with a whole
+  // cluster of entries.
+  size_type index = 0;
+  while (!old.empty(index)) ++index;
+  migration.index = migration.reduction.wrap(index + 1);
+  if (load_ == 0) migration.table.reset();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename K>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    prepare_mutation(migration_state& migration, const K& key,
+                     std::size_t hash) {
+  // Modifications only touch the new table. A key of the old table is
+  // migrated together with its cluster first.
+  if (!migration.table) {
+    prepare_table(migration);
+    return;
+  }
+  migrate(migration, rehash_policy::migration_step);
+  if (!migration.table) return;
+  const auto [index, found] =
+      probe(*migration.table, migration.reduction, key, hash);
+  if (found) migrate_cluster(migration, index);
+  if (migration.load == 0) migration.table.reset();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::prepare_table(
+    migration_state& migration) {
+  // The table is prepared for the capacity which grow would choose now.
+  const auto limit = table_.size() * max_load_factor();
+  const auto used = load_ + tombstones_ + 1;
+  const auto count = reduction_policy::capacity(std::max(
+      {(2 * (load_ + 1) < limit) ? table_.size() : 2 * table_.size(),
+       container::min_capacity, load_ + 1}));
+  auto& next = migration.next;
+  if (next && migration.next_capacity != count) next.reset();
+  // The modifications which are left until the table has to grow.
+  const auto remaining =
+      static_cast<size_type>(std::max<real_type>(limit - used, 1));
+  if (!next) {
+    // The memory is reserved as late as possible. Hence, tables which stop
+    // growing do not keep it. The slots are initialized in steps of at least
+    // migration_step slots.
+    if (remaining > count / rehash_policy::migration_step) return;
+    next.emplace(0, get_allocator());
+    next->reserve(count);
+    migration.next_capacity = count;
+  }
+  const auto initialized = next->size();
+  const auto step = (count - initialized + remaining - 1) / remaining;
+  next->resize(std::min(count, initialized + step));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::migrate(
+    migration_state& migration, size_type slots) {
+  for (size_type n = 0; n < slots && migration.load > 0;) {
+    const auto& old = *migration.table;
+    auto& index = migration.index;
+    if (old.empty(index)) {
+      index = migration.reduction.wrap(index + 1);
+      ++n;
+    } else {
+      const auto last = migrate_cluster(migration, index);
+      n += (index < last) ? last - index : last + old.size() - index;
+      index = last;
+    }
+  }
+  if (migration.load == 0) migration.table.reset();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    migrate_cluster(migration_state& migration, size_type index) -> size_type {
+  // Probe sequences never cross empty slots. Hence, the remaining entries of
+  // the old table stay reachable if whole clusters of non-empty slots are
+  // migrated at once. Returns the index of the empty slot behind the cluster.
+  auto& old = *migration.table;
+  const auto prev = [&](size_type i) {
+    return ((i == 0) ? old.size() : i) - 1;
+  };
+  while (!old.empty(prev(index))) index = prev(index);
+  for (; !old.empty(index); index = migration.reduction.wrap(index + 1)) {
+    if (old.full(index)) {
+      const auto hash = slot_hash(old, index);
+      if (!place(vacant_index(hash), hash, std::move(old.key(index)),
+                 std::move(old.value(index))))
+        throw std::overflow_error{"The probe distance exceeds its maximum!"};
+      --migration.load;
+    }
+    old.destroy(index);
+  }
+  return index;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+bool hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::rehashing()
+    const noexcept {
+  if constexpr (incremental)
+    return migration_.table.has_value();
+  else
+    return false;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::stats() const
+    -> hash_map_stats {
+  hash_map_stats result{};
+  result.size = size();
+  result.capacity = capacity();
+  result.tombstones = tombstones_;
+  result.load_factor = load_factor();
+  stats_.fill(result);
+  return result;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::memory_usage()
+    const -> hash_map_memory {
+  hash_map_memory result{};
+  result.table_bytes = table_.memory_bytes();
+  result.padding_bytes = table_.padding_bytes();
+  if constexpr (incremental) {
+    if (rehashing()) {
+      result.table_bytes += migration_.table->memory_bytes();
+      result.padding_bytes += migration_.table->padding_bytes();
+    }
+    if (migration_.next) {
+      result.table_bytes += migration_.next->memory_bytes();
+      result.padding_bytes += migration_.next->padding_bytes();
+    }
+  }
+  if constexpr (heap_size<key_type>::enabled) {
+    for_each([&](const key_type& key, const mapped_type&) {
+      result.key_heap_bytes += heap_size<key_type>{}(key);
+    });
+  }
+  return result;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    dump_distribution(std::ostream& out) const {
+  // The n-th entry counts the entries with probe distance n and the clusters
+  // of length n, respectively.
+  std::vector<size_type> distances{};
+  std::vector<size_type> clusters{};
+  const auto add = [](std::vector<size_type>& histogram, size_type n) {
+    if (histogram.size() <= n) histogram.resize(n + 1);
+    ++histogram[n];
+  };
+  const auto visit = [&](const container& table,
+                         const reduction_policy& reduction) {
+    const auto size = table.size();
+    size_type cluster = 0;
+    for (size_type i = 0; i < size; ++i) {
+      if (!table.full(i)) {
+        if (cluster > 0) add(clusters, cluster);
+        cluster = 0;
+        continue;
+      }
+      ++cluster;
+      const auto home = reduction.index(slot_hash(table, i));
+      add(distances, (home <= i) ? i - home : i + size - home);
+    }
+    if (cluster > 0) add(clusters, cluster);
+  };
+  if constexpr (incremental)
+    if (rehashing()) visit(*migration_.table, migration_.reduction);
+  visit(table_, reduction_);
+
+  out << "# probe distance\tentries\n";
+  for (size_type n = 0; n < distances.size(); ++n)
+    if (distances[n] > 0) out << n << '\t' << distances[n] << '\n';
+  out << "# cluster length\tclusters\n";
+  for (size_type n = 0; n < clusters.size(); ++n)
+    if (clusters[n] > 0) out << n << '\t' << clusters[n] << '\n';
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::rehash(
+    size_type count, execution::parallel_policy policy) {
+  const auto threads = detail::thread_count(policy.threads);
+  if (threads == 1) return rehash(count);
+  [[maybe_unused]] const auto timer = stats_.time_rehash();
+  if constexpr (incremental) {
+    if (rehashing()) migrate(migration_, std::numeric_limits<size_type>::max());
+    migration_.next.reset();
+  }
+  count = reduction_policy::capacity(
+      std::max({count, container::min_capacity, load_ + 1}));
+  container old_table(count, get_allocator());
+  table_.swap(old_table);
+  reduction_ = reduction_policy{count};
+  tombstones_ = 0;
+  load_ = 0;
+  const auto overflow = fill_regions(table_source{old_table, *this}, threads);
+  for (const auto& entry : overflow) {
+    if (!place(vacant_index(entry.hash), entry.hash,
+               std::move(old_table.key(entry.item)),
+               std::move(old_table.value(entry.item))))
+      throw std::overflow_error{"The probe distance exceeds its maximum!"};
     ++load_;
-    table_[index] = {key, mapped_type{}};
-    if (load_ >= table_.size() * max_load_factor()) {
-      rehash(2 * table_.size());
-      // index was invalidated through rehash
-      return table_[node_index(key)].value;
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Random_access_iterator>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::build_from(
+    Random_access_iterator first, Random_access_iterator last,
+    size_type threads, const allocator_type& alloc) -> hash_map {
+  hash_map map{alloc};
+  map.reserve(last - first);
+  threads = detail::thread_count(threads);
+  if (threads == 1) {
+    map.insert(first, last);
+    return map;
+  }
+  const auto overflow = map.fill_regions(
+      range_source<Random_access_iterator>{first, size_type(last - first),
+                                           map},
+      threads);
+  for (const auto& entry : overflow)
+    map.insert_or_assign_key(first[entry.item].first, first[entry.item].second);
+  return map;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+struct hash_map<Key, T, Hash, Key_equal, Allocator,
+                Policies...>::table_source {
+  // The keys of a table are unique.
+  static constexpr bool unique = true;
+  size_type size() const { return table.size(); }
+  bool contains(size_type i) const { return table.full(i); }
+  std::size_t hash(size_type i) const { return map.slot_hash(table, i); }
+  const key_type& key(size_type i) const { return table.key(i); }
+  // The old table is discarded. Hence, its entries are moved, not copied.
+  void construct(container& to, size_type index, std::size_t hash,
+                 size_type i) const {
+    to.construct(index, hash, std::move(table.key(i)),
+                 std::move(table.value(i)));
+  }
+  void assign(container&, size_type, size_type) const {}
+
+  container& table;
+  const hash_map& map;
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Iterator>
+struct hash_map<Key, T, Hash, Key_equal, Allocator,
+                Policies...>::range_source {
+  static constexpr bool unique = false;
+  size_type size() const { return count; }
+  bool contains(size_type) const { return true; }
+  std::size_t hash(size_type i) const {
+    return map.hash_ref()(first[i].first);
+  }
+  const key_type& key(size_type i) const { return first[i].first; }
+  void construct(container& to, size_type index, std::size_t hash,
+                 size_type i) const {
+    to.construct(index, hash, first[i].first, first[i].second);
+  }
+  void assign(container& to, size_type index, size_type i) const {
+    to.value(index) = first[i].second;
+  }
+
+  Iterator first;
+  size_type count;
+  const hash_map& map;
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Source>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::probe_region(
+    const Source& source, const bulk_entry& entry, size_type last)
+    -> std::pair<size_type, bool> {
+  // Like probe and place but only slots in [entry.home, last) are accessed. The
+  // returned index equals last if the entry does not fit. Otherwise, a vacant
+  // slot is prepared for the entry.
+  auto index = entry.home;
+  if constexpr (robin_hood) {
+    for (size_type d = 0;; ++d, ++index) {
+      if (index == last) return {last, false};
+      if (table_.empty(index) || table_.distance(index) < d) break;
+      if (table_.distance(index) == d &&
+          matches(table_, index, source.key(entry.item), entry.hash))
+        return {index, true};
+    }
+    if (index - entry.home > container::max_distance) return {last, false};
+    // The entries in [index, vacant) are shifted one slot to the back.
+    auto vacant = index;
+    for (; table_.full(vacant); ++vacant) {
+      if (vacant + 1 == last ||
+          table_.distance(vacant) == container::max_distance)
+        return {last, false};
+    }
+    for (; vacant != index; --vacant) {
+      table_.move(vacant - 1, vacant);
+      table_.distance(vacant, table_.distance(vacant) + 1);
+    }
+    return {index, false};
+  } else {
+    for (; index != last && table_.full(index); ++index) {
+      if constexpr (!Source::unique)
+        if (matches(table_, index, source.key(entry.item), entry.hash))
+          return {index, true};
     }
+    return {index, false};
   }
-  return table_[index].value;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::at(const key_type& key) const
-    -> const mapped_type& {
-  const auto index = node_index(key);
-  if (table_[index].empty)
-    throw std::out_of_range{"The given key was not inserted!"};
-  return table_[index].value;
+          typename Allocator, typename... Policies>
+template <typename Source>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::fill_regions(
+    const Source& source, size_type threads) -> std::vector<bulk_entry> {
+  // The table is split into one region of home indices per thread. Every
+  // thread only writes to its own region. Hence, the regions are filled
+  // without synchronization. Entries whose probe sequences would leave their
+  // region are returned and have to be inserted afterwards. The regions
+  // consist of whole blocks of 64 slots. Hence, layouts may pack the states of
+  // a block into one word.
+  constexpr size_type block = 64;
+  const auto size = table_.size();
+  const auto blocks = (size + block - 1) / block;
+  const auto region_begin = [&](size_type r) {
+    return std::min(size, (r * blocks + threads - 1) / threads * block);
+  };
+  const auto region = [&](size_type home) {
+    return home / block * threads / blocks;
+  };
+
+  // First, every thread hashes a contiguous part of the source and sorts the
+  // entries into buckets by their region.
+  std::vector<std::vector<bulk_entry>> buckets(threads * threads);
+  detail::parallel_for(threads, [&](size_type t) {
+    const auto last = (t + 1) * source.size() / threads;
+    for (auto i = t * source.size() / threads; i < last; ++i) {
+      if (!source.contains(i)) continue;
+      const auto hash = source.hash(i);
+      const auto home = home_index(hash);
+      buckets[t * threads + region(home)].push_back({home, hash, i});
+    }
+  });
+
+  // Then, every thread inserts the entries of its region in the order of the
+  // source. The probe sequences are cut off at the end of the region.
+  std::vector<std::vector<bulk_entry>> overflows(threads);
+  std::vector<size_type> loads(threads);
+  detail::parallel_for(threads, [&](size_type r) {
+    const auto last = region_begin(r + 1);
+    for (size_type t = 0; t < threads; ++t) {
+      for (const auto& entry : buckets[t * threads + r]) {
+        const auto [index, found] = probe_region(source, entry, last);
+        if (found) {
+          source.assign(table_, index, entry.item);
+        } else if (index == last) {
+          overflows[r].push_back(entry);
+        } else {
+          source.construct(table_, index, entry.hash, entry.item);
+          if constexpr (robin_hood)
+            table_.distance(index, distance(entry.home, index));
+          ++loads[r];
+        }
+      }
+      buckets[t * threads + r] = {};
+    }
+  });
+
+  std::vector<bulk_entry> overflow;
+  for (size_type r = 0; r < threads; ++r) {
+    load_ += loads[r];
+    overflow.insert(overflow.end(), overflows[r].begin(), overflows[r].end());
+  }
+  return overflow;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::save(
+    std::ostream& out) const {
+  using detail::serializer;
+  detail::snapshot_writer writer{out};
+  detail::snapshot_header header{};
+  std::memcpy(header.magic, header.magic_value, sizeof(header.magic));
+  header.version = header.current_version;
+  // Tombstones are not written. Without them, the entries behind them would
+  // not be reachable from their home indices.
+  const auto positional = !rehashing() && tombstones_ == 0;
+  header.flags = positional ? header.positional : 0;
+  header.hasher_id = detail::hasher_id(hash_ref());
+  header.probing_id =
+      detail::type_id<std::pair<probing_policy, reduction_policy>>();
+  header.key_id = detail::type_id<key_type>();
+  header.value_id = detail::type_id<mapped_type>();
+  header.capacity = table_.size();
+  header.size = load_;
+  writer.write(&header, sizeof(header));
+
+  const auto write_entry = [&](std::uint64_t index, std::uint64_t hash,
+                               const key_type& key, const mapped_type& value) {
+    writer.write(&index, sizeof(index));
+    writer.write(&hash, sizeof(hash));
+    serializer<key_type>::write(writer, key);
+    serializer<mapped_type>::write(writer, value);
+  };
+  if (positional) {
+    for (auto i = table_.next_full(0); i < table_.size();
+         i = table_.next_full(i + 1))
+      write_entry(i, slot_hash(table_, i), table_.key(i), table_.value(i));
+  } else {
+    for (const auto& [key, value] : *this)
+      write_entry(0, hash_ref()(key), key, value);
+  }
+  writer.finish();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::load(
+    std::istream& in) {
+  using detail::serializer;
+  detail::snapshot_reader reader{in};
+  detail::snapshot_header header;
+  reader.read(&header, sizeof(header));
+  if (std::memcmp(header.magic, header.magic_value, sizeof(header.magic)) ||
+      header.version != header.current_version)
+    throw std::runtime_error{"The stream contains no compatible snapshot!"};
+  if (header.key_id != detail::type_id<key_type>() ||
+      header.value_id != detail::type_id<mapped_type>())
+    throw std::runtime_error{"The snapshot has other key or value types!"};
+
+  // The new content is built aside. Hence, errors leave the map unchanged.
+  hash_map map{hash_ref(), get_allocator()};
+  map.max_load_factor_ = max_load_factor_;
+  const auto same_hash = header.hasher_id == detail::hasher_id(hash_ref());
+  const auto restore =
+      same_hash && (header.flags & header.positional) &&
+      header.probing_id ==
+          detail::type_id<std::pair<probing_policy, reduction_policy>>() &&
+      header.size < header.capacity &&
+      reduction_policy::capacity(header.capacity) == header.capacity;
+  if (restore) {
+    container table(header.capacity, get_allocator());
+    map.table_.swap(table);
+    map.reduction_ = reduction_policy{header.capacity};
+  } else {
+    map.reserve(header.size);
+  }
+
+  for (std::uint64_t n = 0; n < header.size; ++n) {
+    std::uint64_t index = 0;
+    std::uint64_t hash = 0;
+    reader.read(&index, sizeof(index));
+    reader.read(&hash, sizeof(hash));
+    auto key = serializer<key_type>::read(reader);
+    auto value = serializer<mapped_type>::read(reader);
+    if (restore) {
+      if (index >= map.table_.size() || !map.table_.empty(index))
+        throw std::runtime_error{"The snapshot is corrupt!"};
+      map.table_.construct(index, hash, std::move(key), std::move(value));
+      if constexpr (robin_hood)
+        map.table_.distance(index, map.distance(map.home_index(hash), index));
+      ++map.load_;
+    } else if (same_hash) {
+      map.insert_vacant(map.vacant_index(hash), hash, std::move(key),
+                        std::move(value));
+    } else {
+      map.insert_or_assign_key(std::move(key), std::move(value));
+    }
+  }
+  reader.finish();
+  *this = std::move(map);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::reserve(
+    size_type count) {
+  rehash(std::ceil(count / max_load_factor()));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::insert(
+    const value_type& value) {
+  insert_or_assign_key(value.first, value.second);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::insert(
+    value_type&& value) {
+  // The key of a value_type is constant and can only be copied.
+  insert_or_assign_key(value.first, std::move(value.second));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename... Args>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::emplace(
+    Args&&... args) -> std::pair<iterator, bool> {
+  std::pair<key_type, mapped_type> value(std::forward<Args>(args)...);
+  return try_emplace_key(std::move(value.first), std::move(value.second));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename... Args>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::try_emplace(
+    const key_type& key, Args&&... args) -> std::pair<iterator, bool> {
+  return try_emplace_key(key, std::forward<Args>(args)...);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename... Args>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::try_emplace(
+    key_type&& key, Args&&... args) -> std::pair<iterator, bool> {
+  return try_emplace_key(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename M>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    insert_or_assign(const key_type& key, M&& obj)
+        -> std::pair<iterator, bool> {
+  return insert_or_assign_key(key, std::forward<M>(obj));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename M>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::
+    insert_or_assign(key_type&& key, M&& obj) -> std::pair<iterator, bool> {
+  return insert_or_assign_key(std::move(key), std::forward<M>(obj));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::operator[](
+    const key_type& key) -> mapped_type& {
+  return try_emplace_key(key).first->second;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::at(const key_type& key)
-    -> mapped_type& {
-  return const_cast<mapped_type&>(const_cast<const hash_map*>(this)->at(key));
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::operator[](
+    key_type&& key) -> mapped_type& {
+  return try_emplace_key(std::move(key)).first->second;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
+          typename Allocator, typename... Policies>
 template <typename Iterator>
-void hash_map<Key, T, Hash, Key_equal, Allocator>::insert(Iterator first,
-                                                          Iterator last) {
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::insert(
+    Iterator first, Iterator last) {
   for (auto it = first; it != last; ++it) (*this)[it->first] = it->second;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
+          typename Allocator, typename... Policies>
 template <typename Key_iterator, typename T_iterator>
-void hash_map<Key, T, Hash, Key_equal, Allocator>::insert(
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::insert(
     Key_iterator keys_first, Key_iterator keys_last, T_iterator first) {
   auto it = first;
   for (auto key_it = keys_first; key_it != keys_last; ++key_it, ++it)
@@ -327,33 +1544,93 @@ void hash_map<Key, T, Hash, Key_equal, Allocator>::insert(
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::find(const key_type& key)
-    -> iterator {
-  const auto index = node_index(key);
-  if (table_[index].empty) return end();
-  return &table_[index];
+          typename Allocator, typename... Policies>
+template <typename K>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::erase_key(
+    const K& key) -> size_type {
+  const auto hash = hash_ref()(key);
+  if constexpr (incremental) prepare_mutation(migration_, key, hash);
+  const auto [index, found] = probe(key, hash);
+  return erase_index(found ? index : table_.size());
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::erase(const key_type& key) {
-  const auto index = node_index(key);
-  if (table_[index].empty) return 0;
-  table_.erase(table_.begin() + index);
+          typename Allocator, typename... Policies>
+auto hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::erase_index(
+    size_type index) -> size_type {
+  if (index == table_.size()) return 0;
+  if constexpr (std::is_same_v<erasure_policy, tombstone_erasure>) {
+    table_.erase(index);
+    ++tombstones_;
+  } else {
+    backward_shift(index);
+  }
+  --load_;
   return 1;
 }
 
 template <typename Key, typename T, typename Hash, typename Key_equal,
-          typename Allocator>
+          typename Allocator, typename... Policies>
+template <typename Key_iterator, typename Function>
+void hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::find_iterators(
+    Key_iterator first, Key_iterator last, Function f) const {
+  // Every key is read twice. Hence, Key_iterator has to be a forward iterator.
+  std::size_t hashes[batch_size];
+  while (first != last) {
+    size_type n = 0;
+    for (auto it = first; n < batch_size && it != last; ++it, ++n) {
+      hashes[n] = hash_ref()(*it);
+      table_.prefetch(home_index(hashes[n]));
+    }
+    for (size_type i = 0; i < n; ++i, ++first) f(lookup(*first, hashes[i]));
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Key_iterator, typename Output_iterator>
+Output_iterator
+hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::find_batch(
+    Key_iterator first, Key_iterator last, Output_iterator out) {
+  find_iterators(first, last,
+                 [&](const_iterator it) { *out++ = mutable_iterator(it); });
+  return out;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Key_iterator, typename Output_iterator>
+Output_iterator
+hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::find_batch(
+    Key_iterator first, Key_iterator last, Output_iterator out) const {
+  find_iterators(first, last, [&](const_iterator it) { *out++ = it; });
+  return out;
+}
 
-auto hash_map<Key, T, Hash, Key_equal, Allocator>::find(
-    const key_type& key) const -> const_iterator {
-  const auto index = node_index(key);
-  if (table_[index].empty) return end();
-  return &table_[index];
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Key_iterator, typename Output_iterator>
+Output_iterator
+hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::contains_batch(
+    Key_iterator first, Key_iterator last, Output_iterator out) const {
+  const auto last_it = end();
+  find_iterators(first, last,
+                 [&](const_iterator it) { *out++ = (it != last_it); });
+  return out;
 }
 
+#if __has_include(<memory_resource>)
+namespace pmr {
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename Key_equal = std::equal_to<Key>, typename... Policies>
+using hash_map = stroupo::hash_map<
+    Key, T, Hash, Key_equal,
+    std::pmr::polymorphic_allocator<std::pair<const Key, T>>, Policies...>;
+
+}  // namespace pmr
+#endif
+
 }  // namespace stroupo
 
 #endif  // STROUPO_HASH_MAP_H_
@@ -0,0 +1,561 @@
+#ifndef STROUPO_HASH_MAP_MAPPED_HASH_MAP_H_
+#define STROUPO_HASH_MAP_MAPPED_HASH_MAP_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <hash_map/hash.h>
+
+namespace stroupo {
+
+namespace detail {
+
+// The header at the beginning of the file of a mapped_hash_map. It is followed
+// by the slots and, for string keys, by the string pool.
+struct mapped_header {
+  static constexpr char magic_value[8] = "stroupo";
+  static constexpr std::uint32_t current_version = 2;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t layout;
+  std::uint32_t key_size;
+  std::uint32_t value_size;
+  std::uint64_t hash_seed;
+  std::uint64_t capacity;
+  std::uint64_t load;
+  // The used and the reserved bytes of the string pool.
+  std::uint64_t pool_size;
+  std::uint64_t pool_capacity;
+};
+static_assert(sizeof(mapped_header) == 64);
+
+// Describes how keys are stored inside the file. Trivially copyable keys are
+// stored in their slots.
+template <typename Key>
+struct mapped_key {
+  static_assert(std::is_trivially_copyable_v<Key>,
+                "Only trivially copyable keys can be stored in a file!");
+  static constexpr std::uint32_t layout = 0;
+  using stored_type = Key;
+  using view_type = Key;
+  static const Key& view(const stored_type& key, const char*) { return key; }
+};
+
+// Strings are stored in a pool behind the slots. The slots only keep their
+// offset and size.
+template <>
+struct mapped_key<std::string> {
+  static constexpr std::uint32_t layout = 1;
+  struct stored_type {
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+  using view_type = std::string_view;
+  static std::string_view view(const stored_type& key, const char* pool) {
+    return {pool + key.offset, key.size};
+  }
+};
+
+template <typename Hash>
+struct is_randomly_seeded : std::false_type {};
+template <typename Hash>
+struct is_randomly_seeded<randomly_seeded<Hash>> : std::true_type {};
+
+}  // namespace detail
+
+// A hash map which lives in a memory-mapped file. Opening an existing file
+// only maps it. Hence, lookups are possible at once and pages are faulted in
+// lazily when they are accessed. All modifications are written to the file.
+// A growing table is built in a temporary file next to it, path + ".tmp",
+// which replaces the file by rename. Hence, a crash during the growth leaves
+// the old table in the file. Other modifications are written in place and are
+// only complete after flush.
+//
+// Keys have to be trivially copyable or std::string. Values have to be
+// trivially copyable. The file stores a versioned header with the capacity,
+// the load, the hash seed and the layout. Opening a file of another layout
+// throws. The file is only portable between processes which compute the same
+// hash values, e.g. the same binary.
+//
+// The hasher is constructed from the seed of the file, like the seeded hashers
+// of hash.h. Hence, files with different seeds place the same keys
+// differently. Hashers without a seed constructor can only be used with the
+// seed 0. Randomly seeded hashers cannot be used, since the hash values of a
+// file have to be reproducible.
+//
+// The table uses linear probing with backward shift erasure and a power of two
+// capacity. It is not thread-safe.
+template <typename Key, typename T,
+          typename Hash =
+              stroupo::hash<typename detail::mapped_key<Key>::view_type>,
+          typename Key_equal = std::equal_to<>>
+class mapped_hash_map {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Only trivially copyable values can be stored in a file!");
+  static_assert(!detail::is_randomly_seeded<Hash>::value,
+                "The hash values of a file have to be reproducible!");
+  using key_traits = detail::mapped_key<Key>;
+  using stored_key = typename key_traits::stored_type;
+  using header = detail::mapped_header;
+  static constexpr bool pooled = key_traits::layout != 0;
+
+  // Full slots have the highest bit of their hash set.
+  struct slot {
+    std::uint64_t hash;
+    stored_key key;
+    T value;
+  };
+  static_assert(alignof(slot) <= sizeof(header));
+
+ public:
+  // Member Types
+  using key_type = Key;
+  using key_view = typename key_traits::view_type;
+  using mapped_type = T;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = Key_equal;
+
+  // Member Constants
+  static constexpr size_type min_capacity = 16;
+
+  // Constructors, Destructors and Assignments
+  // Opens the map stored in the given file or creates it. The hash seed is only
+  // used for new files. Existing files keep their seed. Throws
+  // std::invalid_argument for a seed other than 0 if the hasher cannot be
+  // seeded.
+  explicit mapped_hash_map(const std::string& path,
+                           std::uint64_t hash_seed = 0);
+  mapped_hash_map(mapped_hash_map&& map) noexcept
+      : hash_{std::move(map.hash_)},
+        path_{std::move(map.path_)},
+        fd_{std::exchange(map.fd_, -1)},
+        data_{std::exchange(map.data_, nullptr)},
+        bytes_{std::exchange(map.bytes_, 0)},
+        shift_{map.shift_} {}
+  mapped_hash_map& operator=(mapped_hash_map&& map) noexcept {
+    std::swap(hash_, map.hash_);
+    std::swap(path_, map.path_);
+    std::swap(fd_, map.fd_);
+    std::swap(data_, map.data_);
+    std::swap(bytes_, map.bytes_);
+    std::swap(shift_, map.shift_);
+    return *this;
+  }
+  mapped_hash_map(const mapped_hash_map&) = delete;
+  mapped_hash_map& operator=(const mapped_hash_map&) = delete;
+  ~mapped_hash_map() { close(); }
+
+  // Capacity
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept { return info().load; }
+  size_type capacity() const noexcept { return info().capacity; }
+  std::uint64_t hash_seed() const noexcept { return info().hash_seed; }
+  hasher hash_function() const { return hash_; }
+
+  // Modifiers
+  // Existing keys get the new value assigned. Returns whether the key was
+  // inserted.
+  bool insert(const key_view& key, const T& value);
+  size_type erase(const key_view& key);
+  void reserve(size_type count);
+  // Writes all modifications to the file.
+  void flush();
+
+  // Lookup
+  // Returns a pointer to the value of the key or nullptr if it is missing.
+  // The pointer is invalidated by the next insertion.
+  T* find(const key_view& key) {
+    const auto index = find_index(key);
+    return (index == capacity()) ? nullptr : &slots()[index].value;
+  }
+  const T* find(const key_view& key) const {
+    return const_cast<mapped_hash_map*>(this)->find(key);
+  }
+  T& at(const key_view& key);
+  const T& at(const key_view& key) const {
+    return const_cast<mapped_hash_map*>(this)->at(key);
+  }
+  bool contains(const key_view& key) const { return find(key) != nullptr; }
+
+  // Iteration
+  // Calls f(key_view, T&) for every entry.
+  template <typename Function>
+  void for_each(Function f);
+  template <typename Function>
+  void for_each(Function f) const;
+
+ private:
+  // Internal Member Functions
+  const header& info() const noexcept {
+    return *reinterpret_cast<const header*>(data_);
+  }
+  header& info() noexcept { return *reinterpret_cast<header*>(data_); }
+  slot* slots() const noexcept {
+    return reinterpret_cast<slot*>(data_ + sizeof(header));
+  }
+  char* pool() const noexcept {
+    return data_ + sizeof(header) + info().capacity * sizeof(slot);
+  }
+  static size_type file_size(size_type capacity, size_type pool_capacity) {
+    return sizeof(header) + capacity * sizeof(slot) + pool_capacity;
+  }
+  key_view view(const slot& s) const {
+    return key_traits::view(s.key, pooled ? pool() : nullptr);
+  }
+  bool in_mapping(const char* p) const {
+    const std::less<const char*> before{};
+    return !before(p, data_) && before(p, data_ + bytes_);
+  }
+  std::uint64_t hash(const key_view& key) const {
+    return hash_(key) | (std::uint64_t{1} << 63);
+  }
+  static hasher seeded_hasher(std::uint64_t seed);
+  size_type home_index(std::uint64_t hash) const {
+    return home_index(hash, shift_);
+  }
+  static size_type home_index(std::uint64_t hash, int shift) {
+    // The multiplication spreads weak hashes over the high bits.
+    return (hash * 0x9e3779b97f4a7c15ull) >> shift;
+  }
+  static int shift_of(size_type capacity) {
+    auto shift = 64;
+    for (auto n = capacity; n >>= 1;) --shift;
+    return shift;
+  }
+  void update_shift() { shift_ = shift_of(capacity()); }
+  size_type next_index(size_type index) const {
+    return (index + 1) & (capacity() - 1);
+  }
+  size_type find_index(const key_view& key) const;
+  size_type pool_append(std::string_view key);
+  void open(const std::string& path, std::uint64_t hash_seed);
+  void map_file(size_type bytes);
+  void resize_file(size_type bytes);
+  void rehash(size_type count);
+  static void throw_system_error(const char* what);
+  void close() noexcept;
+
+ private:
+  // Internal Member Variables
+  hasher hash_{};
+  std::string path_{};
+  int fd_{-1};
+  char* data_{nullptr};
+  size_type bytes_{0};
+  int shift_{64};
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+mapped_hash_map<Key, T, Hash, Key_equal>::mapped_hash_map(
+    const std::string& path, std::uint64_t hash_seed) {
+  // The destructor is not called if the constructor throws.
+  try {
+    open(path, hash_seed);
+  } catch (...) {
+    close();
+    throw;
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::open(const std::string& path,
+                                                    std::uint64_t hash_seed) {
+  path_ = path;
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) throw_system_error("Could not open the file of the map!");
+  struct stat status;
+  if (::fstat(fd_, &status) != 0)
+    throw_system_error("Could not read the size of the file!");
+
+  if (status.st_size == 0) {
+    // An empty file is initialized again if the seed is rejected.
+    hash_ = seeded_hasher(hash_seed);
+    resize_file(file_size(min_capacity, 0));
+    auto& h = info();
+    std::memcpy(h.magic, header::magic_value, sizeof(h.magic));
+    h.version = header::current_version;
+    h.layout = key_traits::layout;
+    h.key_size = sizeof(stored_key);
+    h.value_size = sizeof(T);
+    h.hash_seed = hash_seed;
+    h.capacity = min_capacity;
+    update_shift();
+    return;
+  }
+
+  if (size_type(status.st_size) < sizeof(header))
+    throw std::runtime_error{"The file is too small to contain a map!"};
+  // Only the mapping is created. The pages are read when they are accessed.
+  map_file(status.st_size);
+  const auto& h = info();
+  if (std::memcmp(h.magic, header::magic_value, sizeof(h.magic)) != 0 ||
+      h.version != header::current_version)
+    throw std::runtime_error{"The file contains no map of this version!"};
+  if (h.layout != key_traits::layout || h.key_size != sizeof(stored_key) ||
+      h.value_size != sizeof(T))
+    throw std::runtime_error{"The file contains a map of another layout!"};
+  if (h.capacity < min_capacity || (h.capacity & (h.capacity - 1)) ||
+      h.load >= h.capacity || h.pool_size > h.pool_capacity)
+    throw std::runtime_error{"The header of the map is corrupt!"};
+  if (bytes_ < file_size(h.capacity, h.pool_capacity))
+    throw std::runtime_error{"The file of the map is truncated!"};
+  hash_ = seeded_hasher(h.hash_seed);
+  update_shift();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+auto mapped_hash_map<Key, T, Hash, Key_equal>::seeded_hasher(
+    std::uint64_t seed) -> hasher {
+  if constexpr (std::is_constructible_v<hasher, std::uint64_t>) {
+    return hasher{seed};
+  } else {
+    if (seed != 0)
+      throw std::invalid_argument{"The hasher of the map cannot be seeded!"};
+    return hasher{};
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+bool mapped_hash_map<Key, T, Hash, Key_equal>::insert(const key_view& key,
+                                                      const T& value) {
+  if (auto* v = find(key)) {
+    *v = value;
+    return false;
+  }
+  if constexpr (pooled) {
+    // A key which is a view into the pool, e.g. of an erased key, would dangle
+    // once the file is remapped. Hence, it is copied first.
+    if (in_mapping(key.data())) return insert(std::string{key}, value);
+  }
+  if (2 * (size() + 1) > capacity()) rehash(2 * capacity());
+  stored_key stored{};
+  if constexpr (pooled)
+    stored = {pool_append(key), key.size()};
+  else
+    stored = key;
+  // The pool may have been remapped. Hence, the slots are accessed afterwards.
+  const auto h = hash(key);
+  auto index = home_index(h);
+  while (slots()[index].hash != 0) index = next_index(index);
+  slots()[index] = slot{h, stored, value};
+  ++info().load;
+  return true;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+auto mapped_hash_map<Key, T, Hash, Key_equal>::erase(const key_view& key)
+    -> size_type {
+  auto hole = find_index(key);
+  if (hole == capacity()) return 0;
+  // Strings of erased keys stay in the pool until the next rehash.
+  auto* s = slots();
+  for (auto index = next_index(hole); s[index].hash != 0;
+       index = next_index(index)) {
+    // An entry may only fill the hole if its home index does not cyclically
+    // lie in (hole, index]. Otherwise it would become unreachable.
+    const auto home = home_index(s[index].hash);
+    if ((hole < index) ? (home <= hole || index < home)
+                       : (home <= hole && index < home)) {
+      s[hole] = s[index];
+      hole = index;
+    }
+  }
+  s[hole] = slot{};
+  --info().load;
+  return 1;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::reserve(size_type count) {
+  if (2 * count > capacity()) rehash(2 * count);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::flush() {
+  if (::msync(data_, bytes_, MS_SYNC) != 0)
+    throw_system_error("Could not write the map to its file!");
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+T& mapped_hash_map<Key, T, Hash, Key_equal>::at(const key_view& key) {
+  auto* value = find(key);
+  if (!value) throw std::out_of_range{"The given key was not inserted!"};
+  return *value;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+template <typename Function>
+void mapped_hash_map<Key, T, Hash, Key_equal>::for_each(Function f) {
+  auto* s = slots();
+  for (size_type i = 0; i < capacity(); ++i)
+    if (s[i].hash != 0) f(view(s[i]), s[i].value);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+template <typename Function>
+void mapped_hash_map<Key, T, Hash, Key_equal>::for_each(Function f) const {
+  const auto* s = slots();
+  for (size_type i = 0; i < capacity(); ++i)
+    if (s[i].hash != 0) f(view(s[i]), std::as_const(s[i].value));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+auto mapped_hash_map<Key, T, Hash, Key_equal>::find_index(
+    const key_view& key) const -> size_type {
+  const auto h = hash(key);
+  const auto* s = slots();
+  for (auto index = home_index(h); s[index].hash != 0;
+       index = next_index(index))
+    if (s[index].hash == h && key_equal{}(view(s[index]), key)) return index;
+  return capacity();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+auto mapped_hash_map<Key, T, Hash, Key_equal>::pool_append(
+    std::string_view key) -> size_type {
+  auto& h = info();
+  if (h.pool_size + key.size() > h.pool_capacity) {
+    // The pool is the end of the file. Hence, it grows without moving.
+    const auto pool_capacity =
+        std::max<size_type>({2 * h.pool_capacity, h.pool_size + key.size(),
+                             4096});
+    resize_file(file_size(h.capacity, pool_capacity));
+    info().pool_capacity = pool_capacity;
+  }
+  const auto offset = info().pool_size;
+  std::memcpy(pool() + offset, key.data(), key.size());
+  info().pool_size += key.size();
+  return offset;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::map_file(size_type bytes) {
+  // The old mapping is only replaced if the new one could be created.
+  void* data =
+      ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) throw_system_error("Could not map the file!");
+  if (data_) ::munmap(data_, bytes_);
+  data_ = static_cast<char*>(data);
+  bytes_ = bytes;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::resize_file(size_type bytes) {
+  // Only rehash shrinks a file, and it writes a new one. Hence, the old
+  // mapping stays valid if this fails.
+  if (::ftruncate(fd_, bytes) != 0)
+    throw_system_error("Could not resize the file of the map!");
+  map_file(bytes);
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::rehash(size_type count) {
+  size_type capacity = min_capacity;
+  while (capacity < std::max(count, 2 * size() + 1)) capacity *= 2;
+  // The strings of the pool are compacted on the way. Hence, the new pool
+  // holds exactly the strings of the entries.
+  size_type pool_capacity = 0;
+  if constexpr (pooled) {
+    for (size_type i = 0; i < this->capacity(); ++i)
+      if (slots()[i].hash != 0) pool_capacity += slots()[i].key.size;
+  }
+
+  // The new table is complete on disk before it replaces the old one. Until
+  // then, the map keeps its old file and mapping if anything fails. The
+  // entries and strings are copied from the old mapping straight into the new
+  // one. Hence, the growth of a table needs no heap memory of its size.
+  const auto bytes = file_size(capacity, pool_capacity);
+  const auto temporary = path_ + ".tmp";
+  struct stat status;
+  if (::fstat(fd_, &status) != 0)
+    throw_system_error("Could not read the mode of the file!");
+  const int fd =
+      ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, status.st_mode);
+  if (fd < 0) throw_system_error("Could not create the file of the grown map!");
+  char* data = nullptr;
+  const auto fail = [&](const char* what) {
+    const auto error = errno;
+    if (data) ::munmap(data, bytes);
+    ::close(fd);
+    ::unlink(temporary.c_str());
+    errno = error;
+    throw_system_error(what);
+  };
+  if (::ftruncate(fd, bytes) != 0)
+    fail("Could not resize the file of the grown map!");
+  void* mapping =
+      ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) fail("Could not map the file of the grown map!");
+  data = static_cast<char*>(mapping);
+
+  // The file is filled with zeros. Hence, all slots are empty.
+  auto& h = *reinterpret_cast<header*>(data);
+  h = info();
+  h.capacity = capacity;
+  h.pool_size = pool_capacity;
+  h.pool_capacity = pool_capacity;
+  auto* s = reinterpret_cast<slot*>(data + sizeof(header));
+  auto* strings = data + sizeof(header) + capacity * sizeof(slot);
+  size_type pool_size = 0;
+  const auto shift = shift_of(capacity);
+  for (size_type i = 0; i < this->capacity(); ++i) {
+    auto e = slots()[i];
+    if (e.hash == 0) continue;
+    if constexpr (pooled) {
+      const auto key = view(e);
+      std::memcpy(strings + pool_size, key.data(), key.size());
+      e.key = {pool_size, key.size()};
+      pool_size += key.size();
+    }
+    auto index = home_index(e.hash, shift);
+    while (s[index].hash != 0) index = (index + 1) & (capacity - 1);
+    s[index] = e;
+  }
+  if (::msync(data, bytes, MS_SYNC) != 0)
+    fail("Could not write the file of the grown map!");
+  if (::rename(temporary.c_str(), path_.c_str()) != 0)
+    fail("Could not replace the file of the map!");
+
+  ::munmap(data_, bytes_);
+  ::close(fd_);
+  fd_ = fd;
+  data_ = data;
+  bytes_ = bytes;
+  update_shift();
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::throw_system_error(
+    const char* what) {
+  throw std::system_error{errno, std::generic_category(), what};
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal>
+void mapped_hash_map<Key, T, Hash, Key_equal>::close() noexcept {
+  if (data_) ::munmap(data_, bytes_);
+  if (fd_ >= 0) ::close(fd_);
+  data_ = nullptr;
+  bytes_ = 0;
+  fd_ = -1;
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_MAPPED_HASH_MAP_H_
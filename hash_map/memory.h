@@ -0,0 +1,51 @@
+#ifndef STROUPO_HASH_MAP_MEMORY_H_
+#define STROUPO_HASH_MAP_MEMORY_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace stroupo {
+
+// The memory owned by a hash_map in bytes.
+struct hash_map_memory {
+  // The arrays of slots and the metadata of the layout, like control bytes or
+  // bitmaps, with their whole reserved capacity. During an incremental
+  // rehash, the old table is included, and so is a next table which is
+  // prepared shortly before the table grows.
+  std::size_t table_bytes{0};
+  // The part of table_bytes which the slots spend on alignment padding.
+  std::size_t padding_bytes{0};
+  // The heap memory owned by the keys. It is only known if heap_size is
+  // specialized for the key type. Otherwise, it is zero.
+  std::size_t key_heap_bytes{0};
+
+  std::size_t total() const { return table_bytes + key_heap_bytes; }
+};
+
+// The number of heap bytes owned by a value. It can be specialized for other
+// types whose memory should be reported by hash_map::memory_usage.
+template <typename T>
+struct heap_size {
+  static constexpr bool enabled = false;
+  std::size_t operator()(const T&) const noexcept { return 0; }
+};
+
+// Short strings which are stored inside the object do not own heap memory.
+template <typename Char, typename Traits, typename Allocator>
+struct heap_size<std::basic_string<Char, Traits, Allocator>> {
+  static constexpr bool enabled = true;
+  std::size_t operator()(
+      const std::basic_string<Char, Traits, Allocator>& s) const noexcept {
+    const void* data = s.data();
+    const void* first = &s;
+    const void* last = &s + 1;
+    const std::less<const void*> less{};
+    if (!less(data, first) && less(data, last)) return 0;
+    return (s.capacity() + 1) * sizeof(Char);
+  }
+};
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_MEMORY_H_
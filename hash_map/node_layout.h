@@ -0,0 +1,168 @@
+#ifndef STROUPO_HASH_MAP_NODE_LAYOUT_H_
+#define STROUPO_HASH_MAP_NODE_LAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hash_map/policy.h>
+#include <hash_map/prefetch.h>
+
+namespace stroupo {
+
+// Every slot is a node which stores its state next to the key and the value.
+// The state of a full node also encodes its probe distance, which is only kept
+// up to date by robin_hood_probing. If Store_hash is set, every node also
+// keeps the hash value of its key.
+struct node_layout {
+  using category = layout_policy_tag;
+
+  template <typename Key, typename T, typename Allocator,
+            bool Store_hash = false>
+  class storage;
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+class node_layout::storage {
+  // Internal Member Types
+  using state_type = std::uint16_t;
+  enum : state_type { empty_state, deleted_state, full_state };
+  struct plain_node;
+  struct hashed_node;
+  using node = std::conditional_t<Store_hash, hashed_node, plain_node>;
+  using node_allocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+  using container = std::vector<node, node_allocator>;
+
+ public:
+  // Member Types
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = typename container::size_type;
+  using difference_type = typename container::difference_type;
+
+  // Member Constants
+  static constexpr size_type group_width = 1;
+  static constexpr size_type min_capacity = 1;
+  static constexpr size_type max_distance = state_type(~0) - full_state;
+
+  // Constructors, Destructors and Assignments
+  storage() = default;
+  explicit storage(size_type count, const Allocator& alloc = Allocator{})
+      : table_(count, alloc) {}
+
+  Allocator get_allocator() const { return Allocator(table_.get_allocator()); }
+
+  // Capacity
+  size_type size() const noexcept { return table_.size(); }
+  void swap(storage& other) noexcept { table_.swap(other.table_); }
+  // Reserves the memory of count slots. Afterwards, resize does not allocate
+  // until there are count slots. Hence, a table can be initialized in steps.
+  void reserve(size_type count) { table_.reserve(count); }
+  // Appends empty slots until there are count slots.
+  void resize(size_type count) { table_.resize(count); }
+  std::size_t memory_bytes() const noexcept {
+    return table_.capacity() * sizeof(node);
+  }
+  std::size_t padding_bytes() const noexcept {
+    return size() * (sizeof(node) - sizeof(key_type) - sizeof(mapped_type) -
+                     sizeof(state_type) - Store_hash * sizeof(std::size_t));
+  }
+
+  // Slot States
+  bool empty(size_type index) const {
+    return table_[index].state == empty_state;
+  }
+  bool full(size_type index) const {
+    return table_[index].state >= full_state;
+  }
+  bool deleted(size_type index) const {
+    return table_[index].state == deleted_state;
+  }
+  size_type next_full(size_type index) const;
+  size_type distance(size_type index) const {
+    return table_[index].state - full_state;
+  }
+  void distance(size_type index, size_type d) {
+    table_[index].state = full_state + d;
+  }
+  void prefetch(size_type index) const { detail::prefetch(&table_[index]); }
+  // Only available if Store_hash is set.
+  std::size_t hash(size_type index) const { return table_[index].hash; }
+
+  // Slot Access
+  const key_type& key(size_type index) const { return table_[index].key; }
+  // Only used to move keys out of a table which is discarded afterwards.
+  key_type& key(size_type index) { return table_[index].key; }
+  mapped_type& value(size_type index) { return table_[index].value; }
+  const mapped_type& value(size_type index) const {
+    return table_[index].value;
+  }
+  value_type& operator[](size_type index) {
+    return *reinterpret_cast<value_type*>(&table_[index]);
+  }
+  const value_type& operator[](size_type index) const {
+    return *reinterpret_cast<const value_type*>(&table_[index]);
+  }
+
+  // Slot Modifiers
+  template <typename K, typename V>
+  void construct(size_type index, std::size_t hash, K&& key, V&& value);
+  void destroy(size_type index) { table_[index] = node{}; }
+  void erase(size_type index);
+  void move(size_type from, size_type to) {
+    table_[to] = std::move(table_[from]);
+  }
+
+ private:
+  container table_;
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct node_layout::storage<Key, T, Allocator, Store_hash>::plain_node {
+  // Member Variables
+  // The order should no be changed.
+  // It is used for an reinterpret_cast to value_type.
+  key_type key{};
+  mapped_type value{};
+  state_type state{empty_state};
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct node_layout::storage<Key, T, Allocator, Store_hash>::hashed_node
+    : plain_node {
+  // Member Variables
+  std::size_t hash{};
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+auto node_layout::storage<Key, T, Allocator, Store_hash>::next_full(
+    size_type index) const -> size_type {
+  while (index < size() && !full(index)) ++index;
+  return index;
+}
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+template <typename K, typename V>
+void node_layout::storage<Key, T, Allocator, Store_hash>::construct(
+    size_type index, std::size_t hash, K&& key, V&& value) {
+  table_[index].key = std::forward<K>(key);
+  table_[index].value = std::forward<V>(value);
+  table_[index].state = full_state;
+  if constexpr (Store_hash) table_[index].hash = hash;
+}
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+void node_layout::storage<Key, T, Allocator, Store_hash>::erase(
+    size_type index) {
+  table_[index] = node{};
+  table_[index].state = deleted_state;
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_NODE_LAYOUT_H_
@@ -0,0 +1,135 @@
+#ifndef STROUPO_HASH_MAP_POLICY_H_
+#define STROUPO_HASH_MAP_POLICY_H_
+
+#include <cstddef>
+#include <type_traits>
+
+namespace stroupo {
+
+// Policy Categories
+struct erasure_policy_tag {};
+struct hash_storage_policy_tag {};
+struct layout_policy_tag {};
+struct probing_policy_tag {};
+struct reduction_policy_tag {};
+struct rehash_policy_tag {};
+struct stats_policy_tag {};
+
+// Erasure Policies
+// Erased slots are refilled by shifting the following entries of their probe
+// sequence one slot back. No tombstones are left in the table.
+struct backward_shift_erasure {
+  using category = erasure_policy_tag;
+};
+
+// Erased slots are marked as deleted. Lookups skip them, insertions reuse
+// them and the next rehash removes them.
+struct tombstone_erasure {
+  using category = erasure_policy_tag;
+};
+
+// Hash Storage Policies
+// The hash value of a stored key is computed again whenever it is needed.
+struct recomputed_hash {
+  using category = hash_storage_policy_tag;
+  static constexpr bool stored = false;
+};
+
+// Every slot keeps the hash value of its key. Probes compare the hash values
+// before the keys and rehashing does not call the hasher. This pays off for
+// keys which are expensive to hash or to compare, like long strings.
+struct stored_hash {
+  using category = hash_storage_policy_tag;
+  static constexpr bool stored = true;
+};
+
+// Probing Policies
+// Keys are placed in the first free slot behind their home index.
+struct linear_probing {
+  using category = probing_policy_tag;
+  static constexpr float max_load_factor = 0.5f;
+};
+
+// Keys with a longer probe distance take the slots of keys with a shorter one.
+// Probe distances stay short and lookups of missing keys stop as soon as they
+// reach a key with a shorter probe distance. This allows higher load factors.
+// The layout has to store probe distances and tombstones are not supported.
+struct robin_hood_probing {
+  using category = probing_policy_tag;
+  static constexpr float max_load_factor = 0.9f;
+};
+
+// Rehash Policies
+// A growing table is rebuilt at once by the insertion which exceeds the maximum
+// load factor.
+struct full_rehash {
+  using category = rehash_policy_tag;
+  static constexpr std::size_t migration_step = 0;
+};
+
+// A growing table keeps its old table next to the new one. Every insertion and
+// erasure migrates at least Step slots of the old table. The slots of the new
+// table are initialized in steps by the preceding modifications. Hence, the
+// latency of a single modification does not grow with the size of the table,
+// apart from releasing the memory of the old table at once. Lookups and
+// iterations visit both tables during a migration. With a Step of at least two,
+// a migration is complete before the new table has to grow again. Otherwise,
+// the rest of the old table is migrated at once.
+template <std::size_t Step = 64>
+struct incremental_rehash {
+  static_assert(Step > 0, "At least one slot has to be migrated per step!");
+  using category = rehash_policy_tag;
+  static constexpr std::size_t migration_step = Step;
+};
+
+// Stats Policies
+// Nothing is counted. The counters of stats() stay zero.
+struct no_stats {
+  using category = stats_policy_tag;
+  static constexpr bool enabled = false;
+};
+
+// Every probe and rehash is counted. Meant for finding the cause of slow maps,
+// like a bad hasher. The counters are also updated by lookups. Hence,
+// concurrent lookups are not allowed.
+struct collect_stats {
+  using category = stats_policy_tag;
+  static constexpr bool enabled = true;
+};
+
+namespace detail {
+
+template <typename Policy, typename = void>
+struct is_policy : std::false_type {};
+
+template <typename Policy>
+struct is_policy<Policy, std::void_t<typename Policy::category>>
+    : std::true_type {};
+
+// Chooses the first policy of the given category or the default if there is
+// none.
+template <typename Category, typename Default, typename... Policies>
+struct select_policy {
+  using type = Default;
+};
+
+template <typename Category, typename Default, typename Policy,
+          typename... Policies>
+struct select_policy<Category, Default, Policy, Policies...> {
+  using type = std::conditional_t<
+      std::is_same_v<typename Policy::category, Category>, Policy,
+      typename select_policy<Category, Default, Policies...>::type>;
+};
+
+}  // namespace detail
+
+template <typename Policy>
+constexpr bool is_policy_v = detail::is_policy<Policy>::value;
+
+template <typename Category, typename Default, typename... Policies>
+using select_policy_t =
+    typename detail::select_policy<Category, Default, Policies...>::type;
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_POLICY_H_
@@ -0,0 +1,23 @@
+#ifndef STROUPO_HASH_MAP_PREFETCH_H_
+#define STROUPO_HASH_MAP_PREFETCH_H_
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+namespace stroupo::detail {
+
+// Hints the processor to load the cache line of the given address for reading.
+inline void prefetch(const void* address) noexcept {
+#if defined(__GNUC__)
+  __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER)
+  _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+  static_cast<void>(address);
+#endif
+}
+
+}  // namespace stroupo::detail
+
+#endif  // STROUPO_HASH_MAP_PREFETCH_H_
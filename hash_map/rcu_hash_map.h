@@ -0,0 +1,216 @@
+#ifndef STROUPO_HASH_MAP_RCU_HASH_MAP_H_
+#define STROUPO_HASH_MAP_RCU_HASH_MAP_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <hash_map/hash_map.h>
+
+namespace stroupo {
+
+// A hash map for read-mostly workloads in the style of read-copy-update.
+// Readers never block. They access an immutable snapshot which is reached
+// through an atomic pointer. Writers build a new snapshot, publish it with an
+// atomic exchange and wait until no reader uses the old one anymore before it
+// is destroyed. Writers are serialized by a mutex.
+//
+// Every write copies the whole map. Hence, a write costs O(size) and n single
+// inserts cost O(n * size). Many changes should be batched into one update()
+// or built in a separate map_type and published at once.
+//
+// The reclamation is epoch based. A reader registers in one of two counters
+// selected by the parity of the current epoch. A writer advances the epoch
+// after publishing and waits for the counters of the previous parity to drain.
+// The counters are striped over cache lines by threads to keep the readers
+// from contending.
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename Key_equal = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>,
+          typename... Policies>
+class rcu_hash_map {
+  // Readers share the snapshot. Hence, their lookups must not count probes.
+  static_assert(
+      !select_policy_t<stats_policy_tag, no_stats, Policies...>::enabled,
+      "The snapshots of an rcu_hash_map cannot collect stats.");
+
+ public:
+  // Member Types
+  using map_type = hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>;
+  using key_type = typename map_type::key_type;
+  using mapped_type = typename map_type::mapped_type;
+  using value_type = typename map_type::value_type;
+  using size_type = typename map_type::size_type;
+
+  // Member Constants
+  static constexpr std::size_t reader_stripes = 64;
+
+  // Constructors, Destructors and Assignments
+  rcu_hash_map() : rcu_hash_map{map_type{}} {}
+  explicit rcu_hash_map(map_type map)
+      : snapshot_{new map_type{std::move(map)}} {}
+  rcu_hash_map(const rcu_hash_map&) = delete;
+  rcu_hash_map& operator=(const rcu_hash_map&) = delete;
+  ~rcu_hash_map() { delete snapshot_.load(); }
+
+  // Readers
+  // Calls f(const map_type&) with the current snapshot and returns its result.
+  // The snapshot stays valid and unchanged until f returns.
+  template <typename Function>
+  decltype(auto) read(Function f) const;
+  // Calls f(const mapped_type&) for the value of the given key if it is
+  // contained.
+  template <typename Function>
+  bool find(const key_type& key, Function f) const;
+  bool contains(const key_type& key) const {
+    return read([&](const map_type& map) { return map.contains(key); });
+  }
+  size_type size() const {
+    return read([](const map_type& map) { return map.size(); });
+  }
+  bool empty() const { return size() == 0; }
+
+  // Writers
+  // Replaces the snapshot. Blocks until no reader uses the old one anymore.
+  void publish(map_type map);
+  // Calls f(map_type&) for a copy of the current snapshot and publishes it.
+  // Applies any number of changes for the cost of one copy.
+  template <typename Function>
+  void update(Function f);
+  // Existing keys get the new value assigned. Like erase(), every call copies
+  // the snapshot.
+  void insert(const value_type& value) {
+    update([&](map_type& map) { map.insert(value); });
+  }
+  size_type erase(const key_type& key);
+
+ private:
+  struct alignas(64) stripe {
+    std::atomic<std::size_t> readers[2]{};
+  };
+
+  // Registers a reader for the lifetime of the guard.
+  class read_guard;
+
+  // Internal Member Functions
+  static std::size_t stripe_index();
+  // Publishes the new snapshot and returns the old one once it is unused.
+  std::unique_ptr<map_type> exchange(std::unique_ptr<map_type> next);
+
+ private:
+  // Internal Member Variables
+  std::atomic<const map_type*> snapshot_;
+  std::atomic<std::size_t> epoch_{0};
+  mutable stripe stripes_[reader_stripes]{};
+  std::mutex writer_mutex_{};
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+class rcu_hash_map<Key, T, Hash, Key_equal, Allocator,
+                   Policies...>::read_guard {
+ public:
+  explicit read_guard(const rcu_hash_map& map)
+      : stripe_{map.stripes_[stripe_index()]} {
+    // If the epoch changes between reading and registering, a writer could
+    // already be waiting for the other parity. Hence, the reader retries.
+    for (;;) {
+      parity_ = map.epoch_.load() & 1;
+      stripe_.readers[parity_].fetch_add(1);
+      if ((map.epoch_.load() & 1) == parity_) break;
+      stripe_.readers[parity_].fetch_sub(1);
+    }
+  }
+  read_guard(const read_guard&) = delete;
+  read_guard& operator=(const read_guard&) = delete;
+  ~read_guard() { stripe_.readers[parity_].fetch_sub(1); }
+
+ private:
+  stripe& stripe_;
+  std::size_t parity_;
+};
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+std::size_t rcu_hash_map<Key, T, Hash, Key_equal, Allocator,
+                         Policies...>::stripe_index() {
+  thread_local const std::size_t index =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+      reader_stripes;
+  return index;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+decltype(auto) rcu_hash_map<Key, T, Hash, Key_equal, Allocator,
+                            Policies...>::read(Function f) const {
+  read_guard guard{*this};
+  return f(*snapshot_.load());
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+bool rcu_hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::find(
+    const key_type& key, Function f) const {
+  return read([&](const map_type& map) {
+    const auto it = map.find(key);
+    if (it == map.end()) return false;
+    f(it->second);
+    return true;
+  });
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto rcu_hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::exchange(
+    std::unique_ptr<map_type> next) -> std::unique_ptr<map_type> {
+  // Only called while the writer mutex is held.
+  std::unique_ptr<map_type> old{
+      const_cast<map_type*>(snapshot_.exchange(next.release()))};
+  // Readers which registered before the epoch changed may still use the old
+  // snapshot. Later readers load the new one.
+  const auto parity = epoch_.fetch_add(1) & 1;
+  for (auto& s : stripes_)
+    while (s.readers[parity].load() != 0) std::this_thread::yield();
+  return old;
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+void rcu_hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::publish(
+    map_type map) {
+  auto next = std::make_unique<map_type>(std::move(map));
+  std::lock_guard lock{writer_mutex_};
+  exchange(std::move(next));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+template <typename Function>
+void rcu_hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::update(
+    Function f) {
+  std::lock_guard lock{writer_mutex_};
+  // Only writers modify the snapshot pointer. Hence, it can be read directly.
+  auto next = std::make_unique<map_type>(*snapshot_.load());
+  f(*next);
+  exchange(std::move(next));
+}
+
+template <typename Key, typename T, typename Hash, typename Key_equal,
+          typename Allocator, typename... Policies>
+auto rcu_hash_map<Key, T, Hash, Key_equal, Allocator, Policies...>::erase(
+    const key_type& key) -> size_type {
+  size_type result = 0;
+  update([&](map_type& map) { result = map.erase(key); });
+  return result;
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_RCU_HASH_MAP_H_
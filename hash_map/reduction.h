@@ -0,0 +1,134 @@
+#ifndef STROUPO_HASH_MAP_REDUCTION_H_
+#define STROUPO_HASH_MAP_REDUCTION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <hash_map/policy.h>
+
+namespace stroupo {
+
+// A reduction policy maps hash values to home indices of a table with the
+// given capacity. Its static member function 'capacity' rounds a requested
+// capacity up to the next one it supports. The member function 'wrap' maps
+// indices smaller than twice the capacity back into the table.
+
+// Uses the remainder of the division by the capacity.
+// Every capacity is supported.
+class modulo_reduction {
+ public:
+  using category = reduction_policy_tag;
+
+  static std::size_t capacity(std::size_t count) noexcept { return count; }
+
+  modulo_reduction() = default;
+  explicit modulo_reduction(std::size_t capacity) noexcept
+      : capacity_{capacity} {}
+
+  std::size_t index(std::size_t hash) const noexcept {
+    return hash % capacity_;
+  }
+  std::size_t wrap(std::size_t index) const noexcept {
+    return (index < capacity_) ? index : index - capacity_;
+  }
+
+ private:
+  std::size_t capacity_{1};
+};
+
+// Uses the lowest bits of the hash value.
+// The capacity is always a power of two.
+class power_of_two_reduction {
+ public:
+  using category = reduction_policy_tag;
+
+  static std::size_t capacity(std::size_t count) noexcept {
+    std::size_t result = 2;
+    while (result < count) result <<= 1;
+    return result;
+  }
+
+  power_of_two_reduction() = default;
+  explicit power_of_two_reduction(std::size_t capacity) noexcept
+      : mask_{capacity - 1} {}
+
+  std::size_t index(std::size_t hash) const noexcept { return hash & mask_; }
+  std::size_t wrap(std::size_t index) const noexcept { return index & mask_; }
+
+ private:
+  std::size_t mask_{1};
+};
+
+// Lemire's multiply-shift reduction uses the highest bits of the product of
+// the hash value and the capacity. Every capacity is supported but the hash
+// values need well distributed high bits. For example, the identity hash of
+// small integers maps every key to the index zero.
+class fastrange_reduction {
+ public:
+  using category = reduction_policy_tag;
+
+  static std::size_t capacity(std::size_t count) noexcept { return count; }
+
+  fastrange_reduction() = default;
+  explicit fastrange_reduction(std::size_t capacity) noexcept
+      : capacity_{capacity} {}
+
+  std::size_t index(std::size_t hash) const noexcept;
+  std::size_t wrap(std::size_t index) const noexcept {
+    return (index < capacity_) ? index : index - capacity_;
+  }
+
+ private:
+  std::size_t capacity_{1};
+};
+
+inline std::size_t fastrange_reduction::index(std::size_t hash) const
+    noexcept {
+  if constexpr (sizeof(std::size_t) <= sizeof(std::uint32_t)) {
+    return (std::uint64_t{hash} * capacity_) >> 32;
+  } else {
+#if defined(__SIZEOF_INT128__)
+    return (static_cast<unsigned __int128>(hash) * capacity_) >> 64;
+#else
+    // The upper half of the 128-bit product is assembled from 32-bit parts.
+    const std::uint64_t a = hash >> 32, b = hash & 0xffffffff;
+    const std::uint64_t c = capacity_ >> 32, d = capacity_ & 0xffffffff;
+    const std::uint64_t bd = b * d, ad = a * d, bc = b * c;
+    const std::uint64_t middle =
+        (bd >> 32) + (ad & 0xffffffff) + (bc & 0xffffffff);
+    return a * c + (ad >> 32) + (bc >> 32) + (middle >> 32);
+#endif
+  }
+}
+
+// Fibonacci hashing uses the highest bits of the product of the hash value and
+// 2^64 divided by the golden ratio. The multiplication mixes all bits of the
+// hash value. Hence, weak hashes like the identity are spread over the table.
+// The capacity is always a power of two.
+class fibonacci_reduction {
+ public:
+  using category = reduction_policy_tag;
+
+  static std::size_t capacity(std::size_t count) noexcept {
+    return power_of_two_reduction::capacity(count);
+  }
+
+  fibonacci_reduction() = default;
+  explicit fibonacci_reduction(std::size_t capacity) noexcept
+      : mask_{capacity - 1}, shift_{64} {
+    while (capacity >>= 1) --shift_;
+  }
+
+  std::size_t index(std::size_t hash) const noexcept {
+    return (std::uint64_t{hash} * 0x9e3779b97f4a7c15ull) >> shift_;
+  }
+  std::size_t wrap(std::size_t index) const noexcept { return index & mask_; }
+
+ private:
+  std::size_t mask_{1};
+  int shift_{63};
+};
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_REDUCTION_H_
@@ -0,0 +1,186 @@
+#ifndef STROUPO_HASH_MAP_SENTINEL_LAYOUT_H_
+#define STROUPO_HASH_MAP_SENTINEL_LAYOUT_H_
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hash_map/policy.h>
+#include <hash_map/prefetch.h>
+
+namespace stroupo {
+
+// The slot states are encoded in the keys. Empty slots hold Empty_key and
+// deleted slots hold Deleted_key. Hence, slots only consist of the key and the
+// value and no padding is spent on a state. These keys cannot be inserted and
+// inserting them throws std::invalid_argument. Tombstones are only supported
+// if a Deleted_key different from Empty_key is given. Probe distances are not
+// stored. Both keys have to be constants like integers, enumerators or null
+// pointers. If Store_hash is set, every slot also keeps the hash value of its
+// key.
+template <auto Empty_key, auto Deleted_key = Empty_key>
+struct sentinel_layout {
+  using category = layout_policy_tag;
+
+  template <typename Key, typename T, typename Allocator,
+            bool Store_hash = false>
+  class storage;
+};
+
+template <auto Empty_key, auto Deleted_key>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+class sentinel_layout<Empty_key, Deleted_key>::storage {
+  // Internal Member Types
+  struct plain_slot;
+  struct hashed_slot;
+  using slot = std::conditional_t<Store_hash, hashed_slot, plain_slot>;
+  using slot_allocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+  using container = std::vector<slot, slot_allocator>;
+
+ public:
+  // Member Types
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = typename container::size_type;
+  using difference_type = typename container::difference_type;
+
+  // Member Constants
+  static constexpr size_type group_width = 1;
+  static constexpr size_type min_capacity = 1;
+  // Probe distances are not stored.
+  static constexpr size_type max_distance = 0;
+
+  // Constructors, Destructors and Assignments
+  storage() = default;
+  explicit storage(size_type count, const Allocator& alloc = Allocator{})
+      : table_(count, alloc) {}
+
+  Allocator get_allocator() const { return Allocator(table_.get_allocator()); }
+
+  // Capacity
+  size_type size() const noexcept { return table_.size(); }
+  void swap(storage& other) noexcept { table_.swap(other.table_); }
+  // Like the ones of node_layout. Default constructed slots hold Empty_key.
+  void reserve(size_type count) { table_.reserve(count); }
+  void resize(size_type count) { table_.resize(count); }
+  std::size_t memory_bytes() const noexcept {
+    return table_.capacity() * sizeof(slot);
+  }
+  std::size_t padding_bytes() const noexcept {
+    return size() * (sizeof(slot) - sizeof(key_type) - sizeof(mapped_type) -
+                     Store_hash * sizeof(std::size_t));
+  }
+
+  // Slot States
+  bool empty(size_type index) const {
+    return table_[index].key == empty_key();
+  }
+  bool full(size_type index) const {
+    return !empty(index) && !deleted(index);
+  }
+  bool deleted(size_type index) const {
+    return has_deleted_key && table_[index].key == deleted_key();
+  }
+  size_type next_full(size_type index) const;
+  void prefetch(size_type index) const { detail::prefetch(&table_[index]); }
+  // Only available if Store_hash is set.
+  std::size_t hash(size_type index) const { return table_[index].hash; }
+
+  // Slot Access
+  const key_type& key(size_type index) const { return table_[index].key; }
+  // Only used to move keys out of a table which is discarded afterwards.
+  key_type& key(size_type index) { return table_[index].key; }
+  mapped_type& value(size_type index) { return table_[index].value; }
+  const mapped_type& value(size_type index) const {
+    return table_[index].value;
+  }
+  value_type& operator[](size_type index) {
+    return *reinterpret_cast<value_type*>(&table_[index]);
+  }
+  const value_type& operator[](size_type index) const {
+    return *reinterpret_cast<const value_type*>(&table_[index]);
+  }
+
+  // Slot Modifiers
+  template <typename K, typename V>
+  void construct(size_type index, std::size_t hash, K&& key, V&& value);
+  void destroy(size_type index) { table_[index] = slot{}; }
+  void erase(size_type index);
+  void move(size_type from, size_type to) {
+    table_[to] = std::move(table_[from]);
+  }
+
+ private:
+  static constexpr bool has_deleted_key =
+      static_cast<key_type>(Deleted_key) != static_cast<key_type>(Empty_key);
+  static constexpr key_type empty_key() {
+    return static_cast<key_type>(Empty_key);
+  }
+  static constexpr key_type deleted_key() {
+    return static_cast<key_type>(Deleted_key);
+  }
+
+ private:
+  container table_;
+};
+
+template <auto Empty_key, auto Deleted_key>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct sentinel_layout<Empty_key, Deleted_key>::storage<
+    Key, T, Allocator, Store_hash>::plain_slot {
+  // Member Variables
+  // The order should no be changed.
+  // It is used for an reinterpret_cast to value_type.
+  key_type key{empty_key()};
+  mapped_type value{};
+};
+
+template <auto Empty_key, auto Deleted_key>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct sentinel_layout<Empty_key, Deleted_key>::storage<
+    Key, T, Allocator, Store_hash>::hashed_slot : plain_slot {
+  // Member Variables
+  std::size_t hash{};
+};
+
+template <auto Empty_key, auto Deleted_key>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+auto sentinel_layout<Empty_key, Deleted_key>::storage<
+    Key, T, Allocator, Store_hash>::next_full(size_type index) const
+    -> size_type {
+  while (index < size() && !full(index)) ++index;
+  return index;
+}
+
+template <auto Empty_key, auto Deleted_key>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+template <typename K, typename V>
+void sentinel_layout<Empty_key, Deleted_key>::storage<
+    Key, T, Allocator, Store_hash>::construct(size_type index, std::size_t hash,
+                                              K&& key, V&& value) {
+  // The slot is not touched if the key is rejected.
+  if (key == empty_key() || (has_deleted_key && key == deleted_key()))
+    throw std::invalid_argument{"The key is reserved by the sentinel layout!"};
+  table_[index].key = std::forward<K>(key);
+  table_[index].value = std::forward<V>(value);
+  if constexpr (Store_hash) table_[index].hash = hash;
+}
+
+template <auto Empty_key, auto Deleted_key>
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+void sentinel_layout<Empty_key, Deleted_key>::storage<
+    Key, T, Allocator, Store_hash>::erase(size_type index) {
+  static_assert(has_deleted_key,
+                "Tombstones need a deleted key different from the empty key!");
+  table_[index] = slot{};
+  table_[index].key = deleted_key();
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_SENTINEL_LAYOUT_H_
@@ -0,0 +1,223 @@
+#ifndef STROUPO_HASH_MAP_SERIALIZATION_H_
+#define STROUPO_HASH_MAP_SERIALIZATION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace stroupo {
+
+namespace detail {
+
+// A checksum which processes four independent words at a time. It detects
+// corrupted and truncated snapshots but is no cryptographic hash.
+inline std::uint64_t checksum(const char* data, std::size_t size) {
+  constexpr std::uint64_t prime = 0x9e3779b97f4a7c15ull;
+  std::uint64_t lanes[4] = {size, prime, ~size, ~prime};
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (int j = 0; j < 4; ++j) {
+      std::uint64_t word;
+      std::memcpy(&word, data + i + 8 * j, 8);
+      lanes[j] = (lanes[j] ^ word) * prime;
+      lanes[j] ^= lanes[j] >> 29;
+    }
+  }
+  std::uint64_t result = 0;
+  for (int j = 0; j < 4; ++j) result = (result ^ lanes[j]) * prime;
+  for (; i < size; ++i)
+    result = (result ^ static_cast<unsigned char>(data[i])) * prime;
+  return result ^ (result >> 32);
+}
+
+// Identifies a type by its name. The identifier is stable for all programs
+// which are compiled by the same compiler.
+template <typename T>
+std::uint64_t type_id() {
+  std::uint64_t result = 0xcbf29ce484222325ull;
+  for (const char* c = typeid(T).name(); *c; ++c)
+    result = (result ^ static_cast<unsigned char>(*c)) * 0x100000001b3ull;
+  return result;
+}
+
+template <typename Hash, typename = void>
+struct has_seed : std::false_type {};
+
+template <typename Hash>
+struct has_seed<Hash, std::void_t<decltype(std::declval<const Hash&>().seed())>>
+    : std::true_type {};
+
+// Identifies a hasher by its type and, if it has one, by its seed. Hashers
+// with random seeds get another identifier in every map.
+template <typename Hash>
+std::uint64_t hasher_id(const Hash& hash) {
+  auto result = type_id<Hash>();
+  if constexpr (has_seed<Hash>::value)
+    result ^= static_cast<std::uint64_t>(hash.seed()) * 0x9e3779b97f4a7c15ull;
+  return result;
+}
+
+// The header of a snapshot of a hash_map.
+struct snapshot_header {
+  static constexpr char magic_value[8] = "strpsnp";
+  static constexpr std::uint32_t current_version = 1;
+  // The entries are stored at the index of their slot.
+  static constexpr std::uint32_t positional = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t hasher_id;
+  std::uint64_t probing_id;
+  std::uint64_t key_id;
+  std::uint64_t value_id;
+  std::uint64_t capacity;
+  std::uint64_t size;
+};
+
+// Writes a stream of frames. Every frame consists of its size, its data and
+// its checksum. The data is buffered. Hence, the underlying stream is written
+// in large sequential blocks.
+class snapshot_writer {
+ public:
+  static constexpr std::size_t frame_size = std::size_t{1} << 16;
+
+  explicit snapshot_writer(std::ostream& out)
+      : out_{out}, buffer_(frame_size) {}
+
+  void write(const void* data, std::size_t bytes) {
+    // Small writes of single keys and values are the common case.
+    if (bytes <= frame_size - size_) {
+      std::memcpy(buffer_.data() + size_, data, bytes);
+      size_ += bytes;
+      return;
+    }
+    const auto* first = static_cast<const char*>(data);
+    while (bytes > 0) {
+      if (size_ == frame_size) flush();
+      const auto n = std::min(bytes, frame_size - size_);
+      std::memcpy(buffer_.data() + size_, first, n);
+      size_ += n;
+      first += n;
+      bytes -= n;
+    }
+  }
+  // Writes the remaining data and an empty frame which ends the snapshot.
+  void finish() {
+    if (size_ > 0) flush();
+    flush();
+    if (!out_) throw std::runtime_error{"The snapshot could not be written!"};
+  }
+
+ private:
+  void flush() {
+    const std::uint64_t size = size_;
+    const auto sum = checksum(buffer_.data(), size_);
+    out_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out_.write(buffer_.data(), size_);
+    out_.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+    size_ = 0;
+  }
+
+ private:
+  std::ostream& out_;
+  std::vector<char> buffer_;
+  std::size_t size_{0};
+};
+
+// Reads the frames of a snapshot_writer and verifies their checksums.
+class snapshot_reader {
+ public:
+  explicit snapshot_reader(std::istream& in) : in_{in} {}
+
+  void read(void* data, std::size_t bytes) {
+    if (bytes <= buffer_.size() - position_) {
+      std::memcpy(data, buffer_.data() + position_, bytes);
+      position_ += bytes;
+      return;
+    }
+    auto* first = static_cast<char*>(data);
+    while (bytes > 0) {
+      if (position_ == buffer_.size()) next_frame();
+      const auto n = std::min(bytes, buffer_.size() - position_);
+      std::memcpy(first, buffer_.data() + position_, n);
+      position_ += n;
+      first += n;
+      bytes -= n;
+    }
+  }
+  // Checks that all data was read and consumes the final empty frame.
+  void finish() {
+    if (position_ == buffer_.size()) next_frame();
+    if (!buffer_.empty())
+      throw std::runtime_error{"The snapshot contains unexpected data!"};
+  }
+
+ private:
+  void next_frame() {
+    std::uint64_t size = 0;
+    std::uint64_t sum = 0;
+    if (!in_.read(reinterpret_cast<char*>(&size), sizeof(size)) ||
+        size > snapshot_writer::frame_size)
+      throw std::runtime_error{"The snapshot is truncated or corrupt!"};
+    buffer_.resize(size);
+    in_.read(buffer_.data(), size);
+    in_.read(reinterpret_cast<char*>(&sum), sizeof(sum));
+    if (!in_ || sum != checksum(buffer_.data(), buffer_.size()))
+      throw std::runtime_error{"The snapshot is truncated or corrupt!"};
+    position_ = 0;
+  }
+
+ private:
+  std::istream& in_;
+  std::vector<char> buffer_;
+  std::size_t position_{0};
+};
+
+// Writes and reads keys and values of snapshots. Trivially copyable types are
+// copied bytewise. Strings are stored with their size.
+template <typename T, typename = void>
+struct serializer {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "There is no serializer for this type!");
+  static void write(snapshot_writer& out, const T& value) {
+    out.write(&value, sizeof(T));
+  }
+  static T read(snapshot_reader& in) {
+    T value;
+    in.read(&value, sizeof(T));
+    return value;
+  }
+};
+
+template <typename Char, typename Traits, typename Allocator>
+struct serializer<std::basic_string<Char, Traits, Allocator>> {
+  using string = std::basic_string<Char, Traits, Allocator>;
+  static void write(snapshot_writer& out, const string& value) {
+    const std::uint64_t size = value.size();
+    out.write(&size, sizeof(size));
+    out.write(value.data(), size * sizeof(Char));
+  }
+  static string read(snapshot_reader& in) {
+    std::uint64_t size = 0;
+    in.read(&size, sizeof(size));
+    string value(size, Char{});
+    in.read(value.data(), size * sizeof(Char));
+    return value;
+  }
+};
+
+}  // namespace detail
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_SERIALIZATION_H_
@@ -0,0 +1,194 @@
+#ifndef STROUPO_HASH_MAP_SOA_LAYOUT_H_
+#define STROUPO_HASH_MAP_SOA_LAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hash_map/policy.h>
+#include <hash_map/prefetch.h>
+
+namespace stroupo {
+
+namespace detail {
+
+// Refers to a key and a value which are not stored next to each other. It can
+// be converted to a pair and decomposed by structured bindings.
+template <typename Key, typename T>
+struct pair_reference {
+  Key& first;
+  T& second;
+
+  template <typename U, typename V>
+  operator std::pair<U, V>() const {
+    return {first, second};
+  }
+};
+
+}  // namespace detail
+
+// Keys and values are kept in separate arrays. The keys are stored with the
+// slot state which also encodes the probe distance like the one of
+// node_layout. Probing only touches the array of keys. Hence, large mapped
+// types do not pollute the cache during lookups. Iterators yield a
+// detail::pair_reference instead of a reference to value_type. Therefore,
+// loops over the map have to bind its entries by auto&& or by value. If
+// Store_hash is set, the hash values are stored next to the keys.
+struct soa_layout {
+  using category = layout_policy_tag;
+
+  template <typename Key, typename T, typename Allocator,
+            bool Store_hash = false>
+  class storage;
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+class soa_layout::storage {
+  // Internal Member Types
+  using state_type = std::uint16_t;
+  enum : state_type { empty_state, deleted_state, full_state };
+  struct plain_key_slot;
+  struct hashed_key_slot;
+  using key_slot =
+      std::conditional_t<Store_hash, hashed_key_slot, plain_key_slot>;
+  template <typename U>
+  using allocator_for =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  using key_container = std::vector<key_slot, allocator_for<key_slot>>;
+
+ public:
+  // Member Types
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using reference = detail::pair_reference<const Key, T>;
+  using const_reference = detail::pair_reference<const Key, const T>;
+  using size_type = typename key_container::size_type;
+  using difference_type = typename key_container::difference_type;
+
+  // Member Constants
+  static constexpr size_type group_width = 1;
+  static constexpr size_type min_capacity = 1;
+  static constexpr size_type max_distance = state_type(~0) - full_state;
+
+  // Constructors, Destructors and Assignments
+  storage() = default;
+  explicit storage(size_type count, const Allocator& alloc = Allocator{})
+      : keys_(count, alloc), values_(count, alloc) {}
+
+  Allocator get_allocator() const { return Allocator(keys_.get_allocator()); }
+
+  // Capacity
+  size_type size() const noexcept { return keys_.size(); }
+  void swap(storage& other) noexcept {
+    keys_.swap(other.keys_);
+    values_.swap(other.values_);
+  }
+  // Both arrays grow together.
+  void reserve(size_type count) {
+    keys_.reserve(count);
+    values_.reserve(count);
+  }
+  void resize(size_type count) {
+    keys_.resize(count);
+    values_.resize(count);
+  }
+  std::size_t memory_bytes() const noexcept {
+    return keys_.capacity() * sizeof(key_slot) +
+           values_.capacity() * sizeof(mapped_type);
+  }
+  std::size_t padding_bytes() const noexcept {
+    return size() * (sizeof(key_slot) - sizeof(key_type) - sizeof(state_type) -
+                     Store_hash * sizeof(std::size_t));
+  }
+
+  // Slot States
+  bool empty(size_type index) const {
+    return keys_[index].state == empty_state;
+  }
+  bool full(size_type index) const { return keys_[index].state >= full_state; }
+  bool deleted(size_type index) const {
+    return keys_[index].state == deleted_state;
+  }
+  size_type next_full(size_type index) const;
+  size_type distance(size_type index) const {
+    return keys_[index].state - full_state;
+  }
+  void distance(size_type index, size_type d) {
+    keys_[index].state = full_state + d;
+  }
+  void prefetch(size_type index) const { detail::prefetch(&keys_[index]); }
+  // Only available if Store_hash is set.
+  std::size_t hash(size_type index) const { return keys_[index].hash; }
+
+  // Slot Access
+  const key_type& key(size_type index) const { return keys_[index].key; }
+  // Only used to move keys out of a table which is discarded afterwards.
+  key_type& key(size_type index) { return keys_[index].key; }
+  mapped_type& value(size_type index) { return values_[index]; }
+  const mapped_type& value(size_type index) const { return values_[index]; }
+  reference operator[](size_type index) {
+    return {keys_[index].key, values_[index]};
+  }
+  const_reference operator[](size_type index) const {
+    return {keys_[index].key, values_[index]};
+  }
+
+  // Slot Modifiers
+  template <typename K, typename V>
+  void construct(size_type index, std::size_t hash, K&& key, V&& value);
+  void destroy(size_type index) {
+    keys_[index] = key_slot{};
+    values_[index] = mapped_type{};
+  }
+  void erase(size_type index) {
+    destroy(index);
+    keys_[index].state = deleted_state;
+  }
+  void move(size_type from, size_type to) {
+    keys_[to] = std::move(keys_[from]);
+    values_[to] = std::move(values_[from]);
+  }
+
+ private:
+  key_container keys_;
+  std::vector<mapped_type, allocator_for<mapped_type>> values_;
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct soa_layout::storage<Key, T, Allocator, Store_hash>::plain_key_slot {
+  // Member Variables
+  key_type key{};
+  state_type state{empty_state};
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+struct soa_layout::storage<Key, T, Allocator, Store_hash>::hashed_key_slot
+    : plain_key_slot {
+  // Member Variables
+  std::size_t hash{};
+};
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+auto soa_layout::storage<Key, T, Allocator, Store_hash>::next_full(
+    size_type index) const -> size_type {
+  while (index < size() && !full(index)) ++index;
+  return index;
+}
+
+template <typename Key, typename T, typename Allocator, bool Store_hash>
+template <typename K, typename V>
+void soa_layout::storage<Key, T, Allocator, Store_hash>::construct(
+    size_type index, std::size_t hash, K&& key, V&& value) {
+  keys_[index].key = std::forward<K>(key);
+  values_[index] = std::forward<V>(value);
+  keys_[index].state = full_state;
+  if constexpr (Store_hash) keys_[index].hash = hash;
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_SOA_LAYOUT_H_
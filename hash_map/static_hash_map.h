@@ -0,0 +1,252 @@
+#ifndef STROUPO_HASH_MAP_STATIC_HASH_MAP_H_
+#define STROUPO_HASH_MAP_STATIC_HASH_MAP_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <hash_map/hash.h>
+
+namespace stroupo {
+
+namespace detail {
+
+// The hashers which can be evaluated in constant expressions.
+template <typename Key, typename = void>
+struct static_hash {
+  using type = fnv1a_hash;
+};
+
+template <typename Key>
+struct static_hash<Key, enable_if_integer_key_t<Key>> {
+  using type = murmur_hash;
+};
+
+template <typename Key>
+using static_hash_t = typename static_hash<Key>::type;
+
+template <typename Value, std::size_t N, std::size_t... I>
+constexpr std::array<Value, N> to_array(const Value (&values)[N],
+                                        std::index_sequence<I...>) {
+  return {{values[I]...}};
+}
+
+// Splits the keys into buckets by the high bits of their hash values. Every
+// bucket gets a pilot which moves all of its keys to free slots by the low
+// bits of their hash values mixed with the pilot, like in PTHash.
+constexpr std::size_t static_bucket_count(std::size_t size) noexcept {
+  return size / 2 + 1;
+}
+
+constexpr std::size_t static_bucket(std::uint64_t hash,
+                                    std::size_t buckets) noexcept {
+  return static_cast<std::size_t>(((hash >> 32) * buckets) >> 32);
+}
+
+constexpr std::size_t static_slot(std::uint64_t hash, std::uint32_t pilot,
+                                  std::size_t size) noexcept {
+  return static_cast<std::size_t>((hash ^ murmur_mix(pilot)) % size);
+}
+
+// A minimal perfect hash function for N keys. Slot i of the table gets the
+// key with the index order[i].
+template <std::size_t N>
+struct static_placement {
+  static constexpr std::size_t buckets = static_bucket_count(N);
+  static constexpr std::uint32_t max_pilot = 1 << 16;
+
+  std::uint64_t seed{0};
+  std::array<std::uint32_t, buckets> pilots{};
+  std::array<std::size_t, N> order{};
+  // The indices of two keys with the same hash value, if place failed due to
+  // them. Otherwise, both are N.
+  std::size_t collision[2]{N, N};
+
+  // Returns false if no pilot could be found for some bucket, e.g. because
+  // two keys have the same hash value. Another seed has to be tried then.
+  constexpr bool place(const std::array<std::uint64_t, N>& hashes);
+};
+
+template <std::size_t N>
+constexpr bool static_placement<N>::place(
+    const std::array<std::uint64_t, N>& hashes) {
+  // The keys are sorted by their bucket. The keys of bucket b have the
+  // indices members[first[b]] to members[first[b + 1] - 1].
+  std::array<std::size_t, buckets + 1> first{};
+  for (std::size_t i = 0; i < N; ++i)
+    ++first[static_bucket(hashes[i], buckets) + 1];
+  std::size_t largest = 0;
+  for (std::size_t b = 0; b < buckets; ++b) {
+    largest = std::max(largest, first[b + 1]);
+    first[b + 1] += first[b];
+  }
+  std::array<std::size_t, N> members{};
+  std::array<std::size_t, buckets> filled{};
+  for (std::size_t i = 0; i < N; ++i) {
+    const auto b = static_bucket(hashes[i], buckets);
+    members[first[b] + filled[b]++] = i;
+  }
+
+  // Large buckets are placed first while most slots are still free.
+  std::array<bool, N> taken{};
+  std::array<std::size_t, N> slots{};
+  for (auto size = largest; size > 0; --size) {
+    for (std::size_t b = 0; b < buckets; ++b) {
+      if (first[b + 1] - first[b] != size) continue;
+      for (std::size_t k = first[b]; k < first[b + 1]; ++k) {
+        for (std::size_t j = first[b]; j < k; ++j) {
+          if (hashes[members[j]] != hashes[members[k]]) continue;
+          collision[0] = members[j];
+          collision[1] = members[k];
+          return false;
+        }
+      }
+      auto pilot = std::uint32_t{0};
+      for (;; ++pilot) {
+        if (pilot == max_pilot) return false;
+        auto fits = true;
+        for (std::size_t k = 0; fits && k < size; ++k) {
+          slots[k] = static_slot(hashes[members[first[b] + k]], pilot, N);
+          fits = !taken[slots[k]];
+          for (std::size_t j = 0; fits && j < k; ++j)
+            fits = slots[j] != slots[k];
+        }
+        if (fits) break;
+      }
+      pilots[b] = pilot;
+      for (std::size_t k = 0; k < size; ++k) {
+        taken[slots[k]] = true;
+        order[slots[k]] = members[first[b] + k];
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace detail
+
+// An immutable map of N entries which can be built in constant expressions.
+// It searches a seed and a minimal perfect hash function for its keys during
+// construction. Hence, constexpr instances are computed by the compiler and
+// can be placed in read-only memory. Every slot holds an entry. Lookups hash
+// the key once, load one pilot and compare one key. Construction takes
+// roughly quadratic time in N and is meant for tables of up to a few thousand
+// entries. It throws std::invalid_argument if two keys are equal. Hash has to
+// be constructible from a seed and both Hash and Key_equal have to be usable
+// in constant expressions to build constexpr instances.
+template <typename Key, typename T, std::size_t N,
+          typename Hash = detail::static_hash_t<Key>,
+          typename Key_equal = std::equal_to<Key>>
+class static_hash_map {
+  // Internal Member Types
+  using placement = detail::static_placement<N>;
+
+ public:
+  // Member Types
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = Key_equal;
+  using reference = const value_type&;
+  using const_reference = const value_type&;
+  using iterator = const value_type*;
+  using const_iterator = const value_type*;
+
+  // Constructors, Destructors and Assignments
+  constexpr explicit static_hash_map(const std::array<value_type, N>& entries)
+      : static_hash_map{entries, search(entries),
+                        std::make_index_sequence<N>{}} {}
+
+  // Iterators
+  constexpr const_iterator begin() const noexcept { return entries_.data(); }
+  constexpr const_iterator end() const noexcept { return begin() + N; }
+
+  // Capacity
+  constexpr bool empty() const noexcept { return N == 0; }
+  constexpr size_type size() const noexcept { return N; }
+
+  // Lookup
+  constexpr const_iterator find(const key_type& key) const;
+  constexpr bool contains(const key_type& key) const {
+    return find(key) != end();
+  }
+  constexpr size_type count(const key_type& key) const {
+    return contains(key);
+  }
+  constexpr const mapped_type& at(const key_type& key) const {
+    const auto it = find(key);
+    if (it == end()) throw std::out_of_range{"The given key is not stored!"};
+    return it->second;
+  }
+
+  // Hash Policy
+  // The seed of the hasher which was found during construction.
+  constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+ private:
+  template <std::size_t... I>
+  constexpr static_hash_map(const std::array<value_type, N>& entries,
+                            const placement& p, std::index_sequence<I...>)
+      : entries_{{entries[p.order[I]]...}}, pilots_{p.pilots}, seed_{p.seed} {}
+
+  static constexpr placement search(const std::array<value_type, N>& entries);
+
+ private:
+  std::array<value_type, N> entries_;
+  std::array<std::uint32_t, placement::buckets> pilots_;
+  std::uint64_t seed_;
+};
+
+template <typename Key, typename T, std::size_t N, typename Hash,
+          typename Key_equal>
+constexpr auto static_hash_map<Key, T, N, Hash, Key_equal>::find(
+    const key_type& key) const -> const_iterator {
+  if constexpr (N == 0) {
+    return end();
+  } else {
+    const std::uint64_t hash = hasher{seed_}(key);
+    const auto pilot = pilots_[detail::static_bucket(hash, placement::buckets)];
+    const auto slot = detail::static_slot(hash, pilot, N);
+    return key_equal{}(entries_[slot].first, key) ? begin() + slot : end();
+  }
+}
+
+template <typename Key, typename T, std::size_t N, typename Hash,
+          typename Key_equal>
+constexpr auto static_hash_map<Key, T, N, Hash, Key_equal>::search(
+    const std::array<value_type, N>& entries) -> placement {
+  placement result{};
+  for (;; ++result.seed) {
+    std::array<std::uint64_t, N> hashes{};
+    for (std::size_t i = 0; i < N; ++i)
+      hashes[i] = hasher{result.seed}(entries[i].first);
+    if (result.place(hashes)) return result;
+    // Equal keys have the same hash value for every seed.
+    const auto [i, j] = result.collision;
+    if (i != N && key_equal{}(entries[i].first, entries[j].first))
+      throw std::invalid_argument{"The given keys are not unique!"};
+    result.collision[0] = result.collision[1] = N;
+  }
+}
+
+// Deduces the number of entries, e.g.
+// constexpr auto map = make_static_hash_map<std::string_view, int>(
+//     {{"GET", 1}, {"PUT", 2}});
+template <typename Key, typename T, std::size_t N>
+constexpr auto make_static_hash_map(const std::pair<Key, T> (&entries)[N]) {
+  return static_hash_map<Key, T, N>{
+      detail::to_array(entries, std::make_index_sequence<N>{})};
+}
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_STATIC_HASH_MAP_H_
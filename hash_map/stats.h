@@ -0,0 +1,109 @@
+#ifndef STROUPO_HASH_MAP_STATS_H_
+#define STROUPO_HASH_MAP_STATS_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace stroupo {
+
+// A snapshot of the state of a hash_map. The counters are only collected by
+// maps with the collect_stats policy. Otherwise, they are zero.
+struct hash_map_stats {
+  static constexpr std::size_t histogram_size = 16;
+
+  // Table
+  std::size_t size{0};
+  std::size_t capacity{0};
+  std::size_t tombstones{0};
+  double load_factor{0};
+
+  // Probe Counters
+  // Every lookup, insertion and erasure probes one sequence of slots. Its
+  // length is counted in slots or, for layouts with control bytes, in groups.
+  std::uint64_t probes{0};
+  std::uint64_t hits{0};
+  std::uint64_t probe_length_sum{0};
+  std::uint64_t max_probe_length{0};
+  // The number of probes which did not end at their first slot or group.
+  std::uint64_t collisions{0};
+  // The n-th entry counts the probes of length n + 1. The last entry also
+  // counts all longer probes.
+  std::array<std::uint64_t, histogram_size> probe_histogram{};
+
+  // Rehash Counters
+  std::uint64_t rehashes{0};
+  double rehash_seconds{0};
+
+  double average_probe_length() const {
+    return probes ? static_cast<double>(probe_length_sum) / probes : 0;
+  }
+};
+
+namespace detail {
+
+// The counters of maps with the collect_stats policy. Lookups of constant maps
+// update them, too. Hence, they are mutable and must not be updated by
+// concurrent lookups.
+class stats_counters {
+ public:
+  // Adds the time until its destruction to the rehash counters.
+  class rehash_timer {
+   public:
+    explicit rehash_timer(const stats_counters& counters)
+        : counters_{counters}, start_{std::chrono::steady_clock::now()} {}
+    rehash_timer(const rehash_timer&) = delete;
+    rehash_timer& operator=(const rehash_timer&) = delete;
+    ~rehash_timer() {
+      const auto end = std::chrono::steady_clock::now();
+      ++counters_.stats_.rehashes;
+      counters_.stats_.rehash_seconds +=
+          std::chrono::duration<double>(end - start_).count();
+    }
+
+   private:
+    const stats_counters& counters_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  void record_probe(std::size_t length, bool found) const noexcept {
+    ++stats_.probes;
+    stats_.hits += found;
+    stats_.probe_length_sum += length;
+    stats_.max_probe_length =
+        std::max<std::uint64_t>(stats_.max_probe_length, length);
+    stats_.collisions += length > 1;
+    const auto bucket = std::min(length, hash_map_stats::histogram_size) - 1;
+    ++stats_.probe_histogram[bucket];
+  }
+  rehash_timer time_rehash() const { return rehash_timer{*this}; }
+  // Only the counters of stats are overwritten.
+  void fill(hash_map_stats& stats) const {
+    const auto table = stats;
+    stats = stats_;
+    stats.size = table.size;
+    stats.capacity = table.capacity;
+    stats.tombstones = table.tombstones;
+    stats.load_factor = table.load_factor;
+  }
+  void reset() noexcept { stats_ = hash_map_stats{}; }
+
+ private:
+  mutable hash_map_stats stats_{};
+};
+
+// The counters of maps without the collect_stats policy. They do nothing.
+struct no_stats_counters {
+  void record_probe(std::size_t, bool) const noexcept {}
+  int time_rehash() const noexcept { return 0; }
+  void fill(hash_map_stats&) const noexcept {}
+  void reset() noexcept {}
+};
+
+}  // namespace detail
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_STATS_H_
@@ -0,0 +1,30 @@
+#ifndef STROUPO_HASH_MAP_STRING_HASH_H_
+#define STROUPO_HASH_MAP_STRING_HASH_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace stroupo {
+
+// A transparent hasher for string keys. Together with the transparent
+// std::equal_to<> it allows lookups with std::string_view and C strings
+// without constructing a temporary std::string.
+struct string_hash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view key) const noexcept {
+    return std::hash<std::string_view>{}(key);
+  }
+  std::size_t operator()(const std::string& key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+  std::size_t operator()(const char* key) const noexcept {
+    return (*this)(std::string_view{key});
+  }
+};
+
+}  // namespace stroupo
+
+#endif  // STROUPO_HASH_MAP_STRING_HASH_H_
@@ -0,0 +1,89 @@
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <hash_map/arena.h>
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+namespace {
+
+template <typename Allocator, typename... Policies>
+using allocator_map = stroupo::hash_map<int, int, std::hash<int>,
+                                        std::equal_to<int>, Allocator,
+                                        Policies...>;
+
+using counting_node_map =
+    allocator_map<counting_allocator<pair<const int, int>>>;
+using counting_control_byte_map =
+    allocator_map<counting_allocator<pair<const int, int>>,
+                  stroupo::control_byte_layout>;
+using arena_node_map =
+    allocator_map<stroupo::arena_allocator<pair<const int, int>>>;
+using arena_control_byte_map =
+    allocator_map<stroupo::arena_allocator<pair<const int, int>>,
+                  stroupo::control_byte_layout>;
+
+}  // namespace
+
+TEST_CASE_TEMPLATE("The hash map allocates all storage through its allocator",
+                   Map, counting_node_map, counting_control_byte_map) {
+  ptrdiff_t bytes = 0;
+  {
+    Map map{typename Map::allocator_type{&bytes}};
+    CHECK(map.get_allocator().bytes == &bytes);
+    CHECK(bytes > 0);
+
+    for (int i = 0; i < 1000; ++i) map[i] = 2 * i;
+    CHECK(map.size() == 1000);
+    CHECK(bytes >= static_cast<ptrdiff_t>(map.capacity() * 2 * sizeof(int)));
+    for (int i = 0; i < 1000; ++i) CHECK(map.at(i) == 2 * i);
+  }
+  CHECK(bytes == 0);
+}
+
+TEST_CASE_TEMPLATE("The hash map can be allocated in an arena", Map,
+                   arena_node_map, arena_control_byte_map) {
+  stroupo::arena arena{};
+  {
+    Map map{typename Map::allocator_type{arena}};
+    CHECK(map.get_allocator().resource() == &arena);
+    for (int i = 0; i < 10000; ++i) map[i] = i + 1;
+    CHECK(map.size() == 10000);
+    CHECK(arena.allocated_bytes() >= map.capacity() * 2 * sizeof(int));
+    CHECK(arena.block_count() > 1);
+    for (int i = 0; i < 10000; ++i) CHECK(map.at(i) == i + 1);
+  }
+  arena.release();
+  CHECK(arena.block_count() == 0);
+  CHECK(arena.allocated_bytes() == 0);
+}
+
+TEST_CASE("The arena aligns its allocations") {
+  stroupo::arena arena{256};
+  for (size_t alignment : {1, 2, 8, 16, 64, 512}) {
+    INFO("alignment = " << alignment);
+    auto p = arena.allocate(3, alignment);
+    CHECK(reinterpret_cast<uintptr_t>(p) % alignment == 0);
+  }
+  // Oversized requests do not fit into the blocks and get their own block.
+  auto p = static_cast<char*>(arena.allocate(1000));
+  p[999] = 'x';
+  CHECK(arena.allocated_bytes() == 6 * 3 + 1000);
+}
+
+#if __has_include(<memory_resource>)
+TEST_CASE("The pmr hash map uses polymorphic memory resources") {
+  std::pmr::monotonic_buffer_resource resource{};
+  stroupo::pmr::hash_map<int, std::string> map{&resource};
+  CHECK(map.get_allocator().resource() == &resource);
+  for (int i = 0; i < 1000; ++i) map[i] = std::to_string(i);
+  for (int i = 0; i < 1000; ++i) CHECK(map.at(i) == std::to_string(i));
+}
+#endif
@@ -0,0 +1,134 @@
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <hash_map/concurrent_hash_map.h>
+#include <hash_map/hash.h>
+#include <hash_map/reduction.h>
+
+using namespace std;
+
+namespace {
+
+using concurrent_map = stroupo::concurrent_hash_map<int, int>;
+
+// Runs f(t) on the given number of threads and waits for all of them.
+template <typename Function>
+void run_threads(int count, Function f) {
+  vector<thread> threads{};
+  for (auto t = 0; t < count; ++t) threads.emplace_back(f, t);
+  for (auto& t : threads) t.join();
+}
+
+}  // namespace
+
+TEST_CASE("The concurrent hash map rounds its shard count up") {
+  CHECK(concurrent_map{1}.shard_count() == 1);
+  CHECK(concurrent_map{5}.shard_count() == 8);
+  CHECK(concurrent_map{}.shard_count() >= thread::hardware_concurrency());
+}
+
+TEST_CASE("The shards of the concurrent hash map get copies of its hasher") {
+  const stroupo::concurrent_hash_map<int, int, stroupo::murmur_hash> map{
+      4, stroupo::murmur_hash{7}};
+  CHECK(map.hash_function().seed() == 7);
+  map.for_each_shard([](const auto& shard) {
+    CHECK(shard.hash_function().seed() == 7);
+  });
+}
+
+TEST_CASE("The shards of the concurrent hash map spread their keys") {
+  // Fibonacci reduction and the choice of the shard must not use the same
+  // bits. Otherwise, the keys of a shard would only reach a few slots.
+  stroupo::concurrent_hash_map<int, int, std::hash<int>, std::equal_to<int>,
+                               std::allocator<std::pair<const int, int>>,
+                               stroupo::fibonacci_reduction>
+      map{16};
+  for (auto i = 0; i < 10000; ++i) map.insert({i, i});
+  map.for_each_shard([](const auto& shard) {
+    const stroupo::fibonacci_reduction reduction{shard.capacity()};
+    set<size_t> slots{};
+    for (const auto& [key, value] : shard)
+      slots.insert(reduction.index(shard.hash_function()(key)));
+    CHECK(2 * slots.size() > shard.size());
+  });
+}
+
+SCENARIO("The concurrent hash map can be used by many threads at once.") {
+  constexpr auto thread_count = 8;
+  constexpr auto count = 5000;
+  concurrent_map map{16};
+  // The assertions are evaluated by the main thread.
+  atomic<int> failures{0};
+
+  GIVEN("threads which insert disjoint ranges of keys") {
+    run_threads(thread_count, [&](int t) {
+      for (auto i = t * count; i < (t + 1) * count; ++i)
+        if (!map.insert({i, 2 * i})) ++failures;
+    });
+    CHECK(failures == 0);
+
+    THEN("every key can be found with its value") {
+      CHECK(map.size() == thread_count * count);
+      for (auto i = 0; i < thread_count * count; ++i) {
+        auto value = 0;
+        CHECK(map.find(i, [&](int v) { value = v; }));
+        CHECK(value == 2 * i);
+      }
+      CHECK(!map.find(-1, [](int) {}));
+      CHECK(!map.contains(thread_count * count));
+    }
+
+    WHEN("all threads update odd keys and erase even keys at the same time") {
+      run_threads(thread_count, [&](int t) {
+        for (auto i = 1; i < thread_count * count; i += 2)
+          if (!map.update(i, [](int& v) { ++v; })) ++failures;
+        for (auto i = t * count; i < (t + 1) * count; i += 2)
+          if (map.erase(i) != 1) ++failures;
+      });
+
+      THEN("no update and no erasure is lost") {
+        CHECK(failures == 0);
+        CHECK(map.size() == thread_count * count / 2);
+        for (auto i = 1; i < thread_count * count; i += 2) {
+          auto value = 0;
+          map.find(i, [&](int v) { value = v; });
+          CHECK(value == 2 * i + thread_count);
+        }
+      }
+    }
+
+    THEN("the shards can be visited one after another") {
+      concurrent_map::size_type total = 0;
+      map.for_each_shard([&](concurrent_map::shard_type& shard) {
+        for (const auto& e : shard) CHECK(e.second == 2 * e.first);
+        total += shard.size();
+      });
+      CHECK(total == thread_count * count);
+      map.clear();
+      CHECK(map.empty());
+    }
+  }
+
+  GIVEN("threads which read while others write the same keys") {
+    for (auto i = 0; i < count; ++i) map.insert({i, 0});
+    run_threads(thread_count, [&](int t) {
+      for (auto i = 0; i < count; ++i) {
+        if (t % 2)
+          map.insert({i, t});
+        else if (!map.find(i, [&](int v) {
+                   if (v >= thread_count) ++failures;
+                 }))
+          ++failures;
+      }
+    });
+
+    THEN("the keys stay present") {
+      CHECK(failures == 0);
+      CHECK(map.size() == count);
+    }
+  }
+}
@@ -0,0 +1,200 @@
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <hash_map/hash.h>
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+namespace {
+
+// Counts how often instances of it are copied.
+struct copy_counted {
+  static inline int copies = 0;
+
+  copy_counted() = default;
+  copy_counted(int v) : value{v} {}
+  copy_counted(const copy_counted& other) : value{other.value} { ++copies; }
+  copy_counted& operator=(const copy_counted& other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+  copy_counted(copy_counted&&) = default;
+  copy_counted& operator=(copy_counted&&) = default;
+
+  friend bool operator==(const copy_counted& lhs, const copy_counted& rhs) {
+    return lhs.value == rhs.value;
+  }
+
+  int value{};
+};
+
+struct copy_counted_hash {
+  size_t operator()(const copy_counted& key) const noexcept {
+    return std::hash<int>{}(key.value);
+  }
+};
+
+template <typename... Policies>
+using counted_map =
+    hashed_policy_map<copy_counted, copy_counted, copy_counted_hash,
+                      Policies...>;
+
+template <typename... Policies>
+using unique_map =
+    policy_map<int, unique_ptr<int>, Policies...>;
+
+// Strings whose allocations are counted.
+using counted_string =
+    basic_string<char, char_traits<char>, counting_allocator<char>>;
+
+struct counted_string_hash {
+  size_t operator()(const counted_string& key) const noexcept {
+    return stroupo::wyhash{}(string_view{key.data(), key.size()});
+  }
+};
+
+template <typename... Policies>
+using string_map = stroupo::hash_map<
+    counted_string, counted_string, counted_string_hash,
+    std::equal_to<counted_string>,
+    counting_allocator<pair<const counted_string, counted_string>>,
+    Policies...>;
+
+}  // namespace
+
+TEST_CASE_TEMPLATE("The hash map does not copy moved entries", map_type,
+                   counted_map<>, counted_map<stroupo::tombstone_erasure>,
+                   counted_map<stroupo::control_byte_layout>,
+                   counted_map<stroupo::robin_hood_probing>) {
+  map_type map{};
+  copy_counted::copies = 0;
+
+  for (int i = 0; i < 1000; ++i) map.try_emplace(copy_counted{i}, 2 * i);
+  for (int i = 1000; i < 2000; ++i) map.emplace(i, 2 * i);
+  for (int i = 2000; i < 3000; ++i) map[copy_counted{i}] = 2 * i;
+  map.rehash(8 * map.capacity());
+  CHECK(map.size() == 3000);
+  CHECK(copy_counted::copies == 0);
+
+  for (int i = 0; i < 3000; ++i) CHECK(map.at(i).value == 2 * i);
+  CHECK(copy_counted::copies == 0);
+
+  map.insert_or_assign(copy_counted{0}, copy_counted{-1});
+  map.insert_or_assign(copy_counted{-1}, copy_counted{-2});
+  CHECK(copy_counted::copies == 0);
+  CHECK(map.at(0).value == -1);
+  CHECK(map.at(-1).value == -2);
+}
+
+TEST_CASE_TEMPLATE("The hash map supports move-only mapped types", map_type,
+                   unique_map<>, unique_map<stroupo::tombstone_erasure>,
+                   unique_map<stroupo::control_byte_layout>,
+                   unique_map<stroupo::robin_hood_probing>) {
+  map_type map{};
+  for (int i = 0; i < 1000; ++i) {
+    const auto [it, inserted] = map.try_emplace(i, make_unique<int>(i));
+    CHECK(inserted);
+    CHECK(it->first == i);
+    CHECK(*it->second == i);
+  }
+  CHECK(map.size() == 1000);
+
+  SUBCASE("try_emplace does not touch the arguments of existing keys.") {
+    auto p = make_unique<int>(-1);
+    const auto [it, inserted] = map.try_emplace(5, std::move(p));
+    CHECK(!inserted);
+    CHECK(*it->second == 5);
+    REQUIRE(p);
+    CHECK(*p == -1);
+  }
+
+  SUBCASE("insert_or_assign replaces the value of existing keys.") {
+    const auto [it, inserted] = map.insert_or_assign(5, make_unique<int>(-5));
+    CHECK(!inserted);
+    CHECK(*it->second == -5);
+    CHECK(map.insert_or_assign(-5, make_unique<int>(5)).second);
+    CHECK(*map.at(-5) == 5);
+  }
+
+  SUBCASE("emplace constructs the entry from its arguments.") {
+    CHECK(map.emplace(-1, make_unique<int>(1)).second);
+    CHECK(!map.emplace(1, make_unique<int>(0)).second);
+    CHECK(*map.at(1) == 1);
+  }
+
+  SUBCASE("entries survive erasure and rehashing.") {
+    for (int i = 0; i < 1000; i += 2) CHECK(map.erase(i) == 1);
+    map.rehash(4 * map.capacity());
+    for (int i = 1; i < 1000; i += 2) CHECK(*map.at(i) == i);
+    map[2000] = make_unique<int>(2000);
+    CHECK(*map.at(2000) == 2000);
+    CHECK(map.size() == 501);
+  }
+}
+
+TEST_CASE("The hash map moves string keys into its table") {
+  stroupo::hash_map<string, string> map{};
+  string key(100, 'k');
+  string value(100, 'v');
+  map.insert({key, value});
+  map.try_emplace(std::move(key), "ignored");
+  CHECK(map.size() == 1);
+  CHECK(map.at(string(100, 'k')) == value);
+
+  string other(100, 'o');
+  map[std::move(other)] = "other";
+  CHECK(other.empty());
+  CHECK(map.at(string(100, 'o')) == "other");
+}
+
+TEST_CASE_TEMPLATE("Growing the hash map only allocates its new tables",
+                   map_type, string_map<>,
+                   string_map<stroupo::control_byte_layout>,
+                   string_map<stroupo::robin_hood_probing>) {
+  ptrdiff_t string_bytes = 0;
+  ptrdiff_t string_allocations = 0;
+  ptrdiff_t table_bytes = 0;
+  ptrdiff_t table_allocations = 0;
+  const counting_allocator<char> strings{&string_bytes, &string_allocations};
+  const typename map_type::allocator_type tables{&table_bytes,
+                                                 &table_allocations};
+
+  // The strings are too long for the small string optimization.
+  vector<pair<counted_string, counted_string>> entries{};
+  for (int i = 0; i < 4000; ++i) {
+    const auto key = string(100, 'k') + to_string(i);
+    entries.emplace_back(counted_string{key.data(), key.size(), strings},
+                         counted_string(100, 'v', strings));
+  }
+  const auto allocations = string_allocations;
+
+  map_type map{tables};
+  for (auto& [key, value] : entries)
+    map.emplace(std::move(key), std::move(value));
+  CHECK(map.size() == 4000);
+  CHECK(string_allocations == allocations);
+
+  // An empty map allocates the same tables for the same capacity.
+  map_type empty{tables};
+  table_allocations = 0;
+  empty.rehash(8 * map.capacity());
+  const auto empty_allocations = table_allocations;
+  table_allocations = 0;
+  map.rehash(8 * map.capacity());
+  CHECK(table_allocations > 0);
+  CHECK(table_allocations == empty_allocations);
+  CHECK(string_allocations == allocations);
+  CHECK(map.at(counted_string{string(100, 'k') + "42", strings}) ==
+        counted_string(100, 'v', strings));
+}
@@ -0,0 +1,126 @@
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hash_map/frozen_hash_map.h>
+#include <hash_map/hash.h>
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+namespace {
+
+// Distinct keys with equal hash values cannot be placed by the levels.
+struct clustering_hash {
+  size_t operator()(int key) const { return key % 8; }
+};
+
+}  // namespace
+
+TEST_CASE("The frozen hash map finds the keys of a hash map and nothing else") {
+  stroupo::hash_map<int, int> map{};
+  for (int i = 0; i < 100000; ++i) map[3 * i] = i;
+  const stroupo::frozen_hash_map<int, int> frozen{map};
+  CHECK(frozen.size() == map.size());
+  for (int i = 0; i < 100000; ++i) {
+    CHECK(frozen.at(3 * i) == i);
+    CHECK(!frozen.contains(3 * i + 1));
+  }
+  size_t visited = 0;
+  for (const auto& [key, value] : frozen) {
+    CHECK(key == 3 * value);
+    ++visited;
+  }
+  CHECK(visited == map.size());
+  CHECK_THROWS_AS(frozen.at(-3), std::out_of_range);
+  // The entries are stored without empty slots.
+  CHECK(frozen.memory_usage().total() < map.memory_usage().total() / 2);
+
+  const stroupo::frozen_hash_map<int, int> empty{};
+  CHECK(empty.empty());
+  CHECK(empty.find(0) == empty.end());
+}
+
+TEST_CASE("The frozen hash map keeps the seed of the hash map's hasher") {
+  hashed_policy_map<int, int, stroupo::murmur_hash> map{
+      stroupo::murmur_hash{7}};
+  for (int i = 0; i < 1000; ++i) map[i] = i;
+  const stroupo::frozen_hash_map<int, int, stroupo::murmur_hash> frozen{map};
+  CHECK(frozen.hash_function().seed() == 7);
+  for (int i = 0; i < 1000; ++i) CHECK(frozen.at(i) == i);
+
+  // Snapshots of frozen maps with other seeds are rebuilt.
+  stroupo::frozen_hash_map<int, int, stroupo::murmur_hash> other{
+      stroupo::murmur_hash{8}};
+  istringstream in{snapshot(frozen)};
+  other.load(in);
+  CHECK(other.hash_function().seed() == 8);
+  for (int i = 0; i < 1000; ++i) CHECK(other.at(i) == i);
+}
+
+TEST_CASE("The frozen hash map is built from a range of strings") {
+  vector<pair<string, size_t>> entries{};
+  for (size_t i = 0; i < 5000; ++i)
+    entries.emplace_back("a key with the number " + to_string(i), i);
+  const stroupo::frozen_hash_map<string, size_t> frozen{entries.begin(),
+                                                        entries.end()};
+  for (const auto& [key, value] : entries) CHECK(frozen.at(key) == value);
+  CHECK(frozen.count("a key with the number 5000") == 0);
+  CHECK(frozen.memory_usage().key_heap_bytes > 0);
+}
+
+TEST_CASE("The frozen hash map handles keys with equal hash values") {
+  vector<pair<int, int>> entries{};
+  for (int i = 0; i < 100; ++i) entries.emplace_back(i, -i);
+  using map_type = stroupo::frozen_hash_map<int, int, clustering_hash>;
+  const map_type frozen{entries.begin(), entries.end()};
+  for (int i = 0; i < 100; ++i) CHECK(frozen.at(i) == -i);
+  CHECK(!frozen.contains(100));
+
+  entries.emplace_back(42, 0);
+  CHECK_THROWS_AS(map_type(entries.begin(), entries.end()),
+                  std::invalid_argument);
+}
+
+TEST_CASE("The frozen hash map is saved and loaded") {
+  stroupo::hash_map<int, int> map{};
+  for (int i = 0; i < 20000; ++i) map[i] = 2 * i;
+  const stroupo::frozen_hash_map<int, int> frozen{map};
+
+  stroupo::frozen_hash_map<int, int> copy{};
+  istringstream in{snapshot(frozen)};
+  copy.load(in);
+  CHECK(copy.size() == frozen.size());
+  for (int i = 0; i < 20000; ++i) CHECK(copy.at(i) == 2 * i);
+
+  // The snapshots are the ones of hash_map.
+  stroupo::frozen_hash_map<int, int> from_map{};
+  istringstream map_in{snapshot(map)};
+  from_map.load(map_in);
+  CHECK(from_map.at(123) == 246);
+  stroupo::hash_map<int, int> thawed{};
+  istringstream frozen_in{snapshot(frozen)};
+  thawed.load(frozen_in);
+  CHECK(thawed.size() == frozen.size());
+  CHECK(thawed.at(123) == 246);
+
+  SUBCASE("Corrupt snapshots leave the map unchanged.") {
+    auto corrupt = snapshot(frozen);
+    corrupt[corrupt.size() / 2] ^= 1;
+    istringstream corrupt_in{corrupt};
+    CHECK_THROWS_AS(copy.load(corrupt_in), std::runtime_error);
+    istringstream other_in{snapshot(frozen)};
+    stroupo::frozen_hash_map<int, long> other{};
+    CHECK_THROWS_AS(other.load(other_in), std::runtime_error);
+    CHECK(copy.size() == 20000);
+    CHECK(copy.at(7) == 14);
+  }
+}
@@ -0,0 +1,162 @@
+#include <doctest/doctest.h>
+
+#include <bitset>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <hash_map/hash.h>
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+namespace {
+
+template <typename Hash>
+using hashed_map =
+    hashed_policy_map<int, int, Hash, stroupo::power_of_two_reduction>;
+
+// The average number of result bits which flip if one key bit flips.
+template <typename Hash>
+double average_avalanche(const Hash& hash) {
+  mt19937_64 rng{42};
+  auto flipped = 0.0;
+  constexpr auto samples = 1000;
+  for (auto i = 0; i < samples; ++i) {
+    const auto key = rng();
+    for (auto bit = 0; bit < 64; ++bit)
+      flipped += bitset<64>(hash(key) ^ hash(key ^ (1ull << bit))).count();
+  }
+  return flipped / (samples * 64);
+}
+
+}  // namespace
+
+TEST_CASE("The integer hashes mix all bits") {
+  // Half of the bits flip on average.
+  const auto murmur = average_avalanche(stroupo::murmur_hash{});
+  CHECK((31 < murmur && murmur < 33));
+  const auto hash = average_avalanche(stroupo::hash<std::uint64_t>{});
+  CHECK(hash == murmur);
+  // Sequential keys get distinct low bits.
+  unordered_set<size_t> low_bits{};
+  for (auto i = 0; i < 1024; ++i)
+    low_bits.insert(stroupo::multiply_xorshift_hash{}(i) & 0xffff);
+  CHECK(low_bits.size() > 1000);
+}
+
+TEST_CASE("The hashes depend on their seed") {
+  CHECK(stroupo::murmur_hash{1}(42) != stroupo::murmur_hash{2}(42));
+  CHECK(stroupo::multiply_xorshift_hash{1}(42) !=
+        stroupo::multiply_xorshift_hash{2}(42));
+  CHECK(stroupo::wyhash{1}("key") != stroupo::wyhash{2}("key"));
+  CHECK(stroupo::crc32c_hash{1}("key") != stroupo::crc32c_hash{2}("key"));
+  CHECK(stroupo::fnv1a_hash{1}("key") != stroupo::fnv1a_hash{2}("key"));
+  CHECK(stroupo::hash<double>{1}(0.5) != stroupo::hash<double>{2}(0.5));
+  using seeded = stroupo::randomly_seeded<stroupo::wyhash>;
+  CHECK(seeded{}.seed() != seeded{}.seed());
+  const seeded hash{};
+  CHECK(seeded{hash}("key") == hash("key"));
+}
+
+TEST_CASE("The string hashes cover every byte") {
+  string data(200, 'a');
+  unordered_set<size_t> hashes{};
+  unordered_set<size_t> crcs{};
+  for (size_t size = 0; size <= data.size(); ++size) {
+    const string_view key{data.data(), size};
+    const auto hash = stroupo::wyhash{}(key);
+    CHECK(hash == stroupo::hash<std::string>{}(string{key}));
+    hashes.insert(hash);
+    crcs.insert(stroupo::crc32c_hash{}(key));
+    // Changing any byte changes the hash value.
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = 'b';
+      CHECK(stroupo::wyhash{}(key) != hash);
+      data[i] = 'a';
+    }
+  }
+  CHECK(hashes.size() == data.size() + 1);
+  CHECK(crcs.size() == data.size() + 1);
+}
+
+TEST_CASE("The CRC32C is computed in hardware and software alike") {
+  const string_view check{"123456789"};
+  CHECK(~stroupo::detail::crc32c(~0u, check.data(), check.size()) ==
+        0xe3069283u);
+  CHECK(~stroupo::detail::crc32c_software(~0u, check.data(), check.size()) ==
+        0xe3069283u);
+  mt19937 rng{random_device{}()};
+  vector<unsigned char> data(1000);
+  for (auto& byte : data) byte = rng();
+  for (size_t size = 0; size < data.size(); size += 37)
+    CHECK(stroupo::detail::crc32c(7, data.data(), size) ==
+          stroupo::detail::crc32c_software(7, data.data(), size));
+}
+
+TEST_CASE("The seeded CRC32C hash does not inherit the checksum collisions") {
+  // Two words with equal checksums are found by the birthday paradox.
+  mt19937_64 rng{42};
+  unordered_map<uint32_t, uint64_t> words{};
+  uint64_t a = 0;
+  uint64_t b = 0;
+  while (a == b) {
+    b = rng();
+    a = words.emplace(stroupo::detail::crc32c(0, &b, sizeof(b)), b)
+            .first->second;
+  }
+  // The checksum is linear. Hence, the collision does not depend on the
+  // initial value.
+  CHECK(stroupo::detail::crc32c(7, &a, sizeof(a)) ==
+        stroupo::detail::crc32c(7, &b, sizeof(b)));
+  for (uint64_t seed = 0; seed < 100; ++seed)
+    CHECK(stroupo::crc32c_hash{seed}(a) != stroupo::crc32c_hash{seed}(b));
+}
+
+TEST_CASE("The maps hash with the hasher they were constructed with") {
+  // Only the seed tells the hashers apart.
+  hashed_map<stroupo::murmur_hash> map{stroupo::murmur_hash{7}};
+  for (auto i = 0; i < 1000; ++i) map[i] = i;
+  CHECK(map.hash_function().seed() == 7);
+  auto copy = map;
+  CHECK(copy.hash_function().seed() == 7);
+  for (auto i = 0; i < 1000; ++i) CHECK(copy.at(i) == i);
+
+  // Snapshots of maps with other seeds are reinserted.
+  hashed_map<stroupo::murmur_hash> other{stroupo::murmur_hash{8}};
+  stringstream snapshot{};
+  map.save(snapshot);
+  other.load(snapshot);
+  CHECK(other.hash_function().seed() == 8);
+  for (auto i = 0; i < 1000; ++i) CHECK(other.at(i) == i);
+
+  using seeded = stroupo::randomly_seeded<stroupo::murmur_hash>;
+  const hashed_map<seeded> first{};
+  const hashed_map<seeded> second{};
+  CHECK(first.hash_function().seed() != second.hash_function().seed());
+}
+
+TEST_CASE_TEMPLATE("The hash map works with the library hashes", Hash,
+                   stroupo::hash<int>, stroupo::multiply_xorshift_hash,
+                   stroupo::crc32c_hash,
+                   stroupo::randomly_seeded<stroupo::murmur_hash>) {
+  hashed_map<Hash> map{};
+  // Strided keys hit the same home index if the hash is the identity.
+  for (auto i = 0; i < 10000; ++i) map[i << 10] = i;
+  for (auto i = 0; i < 10000; ++i) CHECK(map.at(i << 10) == i);
+  CHECK(!map.contains(1));
+
+  stringstream snapshot{};
+  map.save(snapshot);
+  hashed_map<Hash> copy{};
+  copy.load(snapshot);
+  CHECK(copy.capacity() == map.capacity());
+  for (auto i = 0; i < 10000; ++i) CHECK(copy.at(i << 10) == i);
+}
@@ -1,6 +1,7 @@
 #include <doctest/doctest.h>
 
 #include <algorithm>
+#include <iterator>
 #include <random>
 #include <type_traits>
 #include <vector>
@@ -382,4 +383,142 @@ SCENARIO("The hash map can be initialized by initializer lists.") {
       CHECK((map.at(5) + 4) * (map.at(5) + 1) == 0);
     }
   }
-}
\ No newline at end of file
+}
+
+using tombstone_hash_map =
+    stroupo::hash_map<key_type, mapped_type, std::hash<key_type>,
+                      std::equal_to<key_type>,
+                      std::allocator<std::pair<const key_type, mapped_type>>,
+                      stroupo::tombstone_erasure>;
+
+template class stroupo::hash_map<
+    key_type, mapped_type, std::hash<key_type>, std::equal_to<key_type>,
+    std::allocator<std::pair<const key_type, mapped_type>>,
+    stroupo::tombstone_erasure>;
+
+using control_byte_hash_map =
+    stroupo::hash_map<key_type, mapped_type, std::hash<key_type>,
+                      std::equal_to<key_type>,
+                      std::allocator<std::pair<const key_type, mapped_type>>,
+                      stroupo::control_byte_layout>;
+using control_byte_tombstone_hash_map =
+    stroupo::hash_map<key_type, mapped_type, custom_hash, custom_equal_to,
+                      std::allocator<std::pair<const key_type, mapped_type>>,
+                      stroupo::control_byte_layout, stroupo::tombstone_erasure>;
+
+template class stroupo::hash_map<
+    key_type, mapped_type, std::hash<key_type>, std::equal_to<key_type>,
+    std::allocator<std::pair<const key_type, mapped_type>>,
+    stroupo::control_byte_layout>;
+
+using robin_hood_hash_map =
+    stroupo::hash_map<key_type, mapped_type, custom_hash, custom_equal_to,
+                      std::allocator<std::pair<const key_type, mapped_type>>,
+                      stroupo::robin_hood_probing>;
+
+template class stroupo::hash_map<
+    key_type, mapped_type, custom_hash, custom_equal_to,
+    std::allocator<std::pair<const key_type, mapped_type>>,
+    stroupo::robin_hood_probing>;
+
+template class stroupo::hash_map<
+    key_type, mapped_type, std::hash<key_type>, std::equal_to<key_type>,
+    std::allocator<std::pair<const key_type, mapped_type>>,
+    stroupo::sentinel_layout<-1, -2>, stroupo::tombstone_erasure>;
+
+template class stroupo::hash_map<
+    key_type, mapped_type, std::hash<key_type>, std::equal_to<key_type>,
+    std::allocator<std::pair<const key_type, mapped_type>>,
+    stroupo::soa_layout, stroupo::robin_hood_probing>;
+
+TEST_CASE_TEMPLATE("The hash map can erase elements", map_type, hash_map,
+                   tombstone_hash_map, custom_hash_map, control_byte_hash_map,
+                   control_byte_tombstone_hash_map, robin_hood_hash_map) {
+  constexpr auto count = 1000;
+  mt19937 rng{random_device{}()};
+  vector<key_type> keys(count);
+  iota(begin(keys), end(keys), -count / 2);
+  shuffle(begin(keys), end(keys), rng);
+
+  map_type map{};
+  for (auto key : keys) map[key] = 2 * key;
+  CHECK(map.size() == count);
+
+  SUBCASE("and returns the number of erased elements.") {
+    CHECK(map.erase(keys[0]) == 1);
+    CHECK(map.size() == count - 1);
+    CHECK(map.erase(keys[0]) == 0);
+    CHECK(map.size() == count - 1);
+    CHECK(map.erase(count) == 0);
+    CHECK(map.size() == count - 1);
+  }
+
+  SUBCASE("and keeps all other elements accessible.") {
+    for (auto i = 0; i < count / 2; ++i) CHECK(map.erase(keys[i]) == 1);
+    CHECK(map.size() == count / 2);
+    for (auto i = 0; i < count / 2; ++i) {
+      CHECK(map.find(keys[i]) == map.end());
+      CHECK_THROWS_AS(map.at(keys[i]), std::out_of_range);
+    }
+    for (auto i = count / 2; i < count; ++i)
+      CHECK_MESSAGE(map.at(keys[i]) == 2 * keys[i], "key = " << keys[i]);
+
+    auto visited = 0;
+    for (const auto& element : map) {
+      CHECK(element.second == 2 * element.first);
+      ++visited;
+    }
+    CHECK(visited == count / 2);
+  }
+
+  SUBCASE("and can reinsert erased elements.") {
+    for (auto i = 0; i < count; ++i) {
+      CHECK(map.erase(keys[i]) == 1);
+      map[keys[(i + count / 3) % count]] += 1;
+      map[keys[i]] = keys[i];
+    }
+    CHECK(map.size() == count);
+    for (auto i = 0; i < count; ++i)
+      CHECK(map.at(keys[i]) == keys[i] + ((i < count / 3) ? 1 : 0));
+  }
+
+  SUBCASE("and becomes empty if all elements are erased.") {
+    for (auto key : keys) CHECK(map.erase(key) == 1);
+    CHECK(map.empty());
+    CHECK(map.begin() == map.end());
+  }
+}
+
+TEST_CASE_TEMPLATE("The hash map looks up batches of keys", map_type, hash_map,
+                   tombstone_hash_map, custom_hash_map, control_byte_hash_map,
+                   control_byte_tombstone_hash_map, robin_hood_hash_map) {
+  constexpr auto count = 1000;
+  mt19937 rng{random_device{}()};
+  // Every second key is missing. The count is no multiple of the batch size.
+  vector<key_type> keys(2 * count + 7);
+  iota(begin(keys), end(keys), -count);
+  shuffle(begin(keys), end(keys), rng);
+
+  map_type map{};
+  for (auto key : keys)
+    if (key % 2 == 0) map[key] = 3 * key;
+  const auto& const_map = map;
+
+  vector<typename map_type::iterator> found{};
+  map.find_batch(begin(keys), end(keys), back_inserter(found));
+  vector<typename map_type::const_iterator> const_found{};
+  const_map.find_batch(begin(keys), end(keys), back_inserter(const_found));
+  vector<bool> contained(keys.size());
+  const auto last =
+      map.contains_batch(begin(keys), end(keys), begin(contained));
+  CHECK(last == end(contained));
+
+  REQUIRE(found.size() == keys.size());
+  REQUIRE(const_found.size() == keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    CHECK(found[i] == map.find(keys[i]));
+    CHECK(const_found[i] == const_map.find(keys[i]));
+    CHECK(contained[i] == (keys[i] % 2 == 0));
+    if (contained[i]) CHECK(found[i]->second == 3 * keys[i]);
+  }
+}
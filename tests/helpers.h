@@ -0,0 +1,89 @@
+#ifndef STROUPO_TESTS_HELPERS_H_
+#define STROUPO_TESTS_HELPERS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hash_map/hash_map.h>
+
+// A hash map with the given hasher and policies. The key equality and the
+// allocator are the default ones.
+template <typename Key, typename T, typename Hash, typename... Policies>
+using hashed_policy_map =
+    stroupo::hash_map<Key, T, Hash, std::equal_to<Key>,
+                      std::allocator<std::pair<const Key, T>>, Policies...>;
+
+template <typename Key, typename T, typename... Policies>
+using policy_map = hashed_policy_map<Key, T, std::hash<Key>, Policies...>;
+
+// The entries of a map in ascending order. Hence, maps with different layouts
+// and capacities can be compared.
+template <typename Map>
+std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>>
+sorted_content(const Map& map) {
+  std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>>
+      content(map.begin(), map.end());
+  std::sort(content.begin(), content.end());
+  return content;
+}
+
+template <typename Map>
+std::string snapshot(const Map& map) {
+  std::ostringstream out{};
+  map.save(out);
+  return out.str();
+}
+
+// Counts the bytes which are currently allocated through all of its copies
+// and, if it is given, the number of allocations. Default constructed
+// instances, like the ones of empty strings in the slots, count nothing. It
+// is propagated by assignments. Hence, moving a string into a slot does not
+// copy it.
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  counting_allocator() = default;
+  explicit counting_allocator(std::ptrdiff_t* bytes,
+                              std::ptrdiff_t* allocations = nullptr) noexcept
+      : bytes{bytes}, allocations{allocations} {}
+  template <typename U>
+  counting_allocator(const counting_allocator<U>& other) noexcept
+      : bytes{other.bytes}, allocations{other.allocations} {}
+
+  T* allocate(std::size_t n) {
+    if (bytes) *bytes += n * sizeof(T);
+    if (allocations) ++*allocations;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (bytes) *bytes -= n * sizeof(T);
+    std::allocator<T>{}.deallocate(p, n);
+  }
+
+  std::ptrdiff_t* bytes{nullptr};
+  std::ptrdiff_t* allocations{nullptr};
+};
+
+template <typename T, typename U>
+bool operator==(const counting_allocator<T>& lhs,
+                const counting_allocator<U>& rhs) {
+  return lhs.bytes == rhs.bytes;
+}
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T>& lhs,
+                const counting_allocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+#endif  // STROUPO_TESTS_HELPERS_H_
@@ -0,0 +1,85 @@
+#include <doctest/doctest.h>
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <hash_map/hash_map.h>
+#include <hash_map/string_hash.h>
+
+using namespace std;
+
+namespace {
+
+template <typename... Policies>
+using string_map =
+    stroupo::hash_map<string, int, stroupo::string_hash, std::equal_to<>,
+                      std::allocator<std::pair<const string, int>>,
+                      Policies...>;
+
+template <typename Map, typename K, typename = void>
+struct has_find : false_type {};
+
+template <typename Map, typename K>
+struct has_find<Map, K,
+                void_t<decltype(declval<Map&>().find(declval<const K&>()))>>
+    : true_type {};
+
+// std::string is not implicitly constructible from std::string_view. Hence,
+// these lookups can only compile without a temporary std::string.
+static_assert(has_find<string_map<>, string_view>::value);
+static_assert(!has_find<stroupo::hash_map<string, int>, string_view>::value);
+
+}  // namespace
+
+TEST_CASE_TEMPLATE("The hash map supports heterogeneous lookup", map_type,
+                   string_map<>, string_map<stroupo::tombstone_erasure>,
+                   string_map<stroupo::control_byte_layout>,
+                   string_map<stroupo::robin_hood_probing>) {
+  map_type map{};
+  for (int i = 0; i < 1000; ++i) map["key" + to_string(i)] = i;
+  const string buffer = "key17key999key1000";
+  const string_view key17{buffer.data(), 5};
+  const string_view key999{buffer.data() + 5, 6};
+  const string_view key1000{buffer.data() + 11, 7};
+
+  SUBCASE("through find, contains and count.") {
+    REQUIRE(map.find(key17) != map.end());
+    CHECK(map.find(key17)->second == 17);
+    CHECK(map.find(key1000) == map.end());
+    CHECK(std::as_const(map).find(key999)->second == 999);
+    CHECK(map.contains(key999));
+    CHECK(!map.contains(key1000));
+    CHECK(map.contains("key0"));
+    CHECK(map.count(key17) == 1);
+    CHECK(map.count(key1000) == 0);
+  }
+
+  SUBCASE("through at.") {
+    CHECK(map.at(key17) == 17);
+    map.at(key17) = -17;
+    CHECK(std::as_const(map).at(key17) == -17);
+    CHECK_THROWS_AS(map.at(key1000), std::out_of_range);
+  }
+
+  SUBCASE("through erase.") {
+    CHECK(map.erase(key17) == 1);
+    CHECK(map.erase(key17) == 0);
+    CHECK(map.erase(key1000) == 0);
+    CHECK(map.size() == 999);
+    CHECK(!map.contains(key17));
+    for (int i = 0; i < 1000; ++i)
+      if (i != 17) CHECK(map.at("key" + to_string(i)) == i);
+  }
+}
+
+TEST_CASE("The transparent string hash agrees with std::hash") {
+  const stroupo::string_hash hash{};
+  const string key = "transparent";
+  CHECK(hash(key) == std::hash<string>{}(key));
+  CHECK(hash(string_view{key}) == hash(key));
+  CHECK(hash(key.c_str()) == hash(key));
+}
@@ -0,0 +1,169 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+#include <hash_map/mapped_hash_map.h>
+
+using namespace std;
+
+namespace {
+
+// Removes the file of a test when it goes out of scope.
+struct temporary_file {
+  temporary_file(const string& name)
+      : path{filesystem::temp_directory_path() /
+             (name + "-" + to_string(::getpid()))} {
+    filesystem::remove(path);
+  }
+  ~temporary_file() { filesystem::remove(path); }
+  filesystem::path path;
+};
+
+struct point {
+  double x, y;
+};
+
+}  // namespace
+
+TEST_CASE("The mapped hash map keeps its entries in a file") {
+  temporary_file file{"stroupo-mapped-int"};
+  constexpr int count = 10000;
+  {
+    stroupo::mapped_hash_map<int, point> map{file.path.string(), 42};
+    CHECK(map.empty());
+    for (int i = 0; i < count; ++i) CHECK(map.insert(i, {i * 0.5, -i * 1.0}));
+    CHECK(!map.insert(7, {1, 2}));
+    CHECK(map.size() == count);
+    for (int i = 0; i < count; i += 2) CHECK(map.erase(i) == 1);
+    CHECK(map.erase(0) == 0);
+    map.flush();
+  }
+
+  stroupo::mapped_hash_map<int, point> map{file.path.string()};
+  CHECK(map.hash_seed() == 42);
+  CHECK(map.size() == count / 2);
+  CHECK(map.at(7).x == 1);
+  for (int i = 1; i < count; i += 2) {
+    if (i == 7) continue;
+    REQUIRE(map.find(i) != nullptr);
+    CHECK(map.find(i)->x == i * 0.5);
+  }
+  for (int i = 0; i < count; i += 2) CHECK(!map.contains(i));
+  CHECK_THROWS_AS(map.at(-1), std::out_of_range);
+
+  int visited = 0;
+  map.for_each([&](int key, point& p) {
+    CHECK(key % 2 == 1);
+    p.y = key;
+    ++visited;
+  });
+  CHECK(visited == count / 2);
+  CHECK(map.at(9).y == 9);
+}
+
+TEST_CASE("The mapped hash map hashes with the seed of its file") {
+  vector<int> orders[2]{};
+  for (uint64_t seed : {1, 2}) {
+    temporary_file file{"stroupo-mapped-seed-" + to_string(seed)};
+    {
+      stroupo::mapped_hash_map<int, int> map{file.path.string(), seed};
+      for (int i = 0; i < 1000; ++i) map.insert(i, i);
+    }
+    stroupo::mapped_hash_map<int, int> map{file.path.string()};
+    CHECK(map.hash_function().seed() == seed);
+    map.for_each([&](int key, int) { orders[seed - 1].push_back(key); });
+  }
+  // The seeds place the same keys differently.
+  CHECK(orders[0] != orders[1]);
+
+  temporary_file unseeded{"stroupo-mapped-unseeded"};
+  using std_map = stroupo::mapped_hash_map<int, int, std::hash<int>>;
+  CHECK_THROWS_AS((std_map{unseeded.path.string(), 7}), std::invalid_argument);
+  CHECK_NOTHROW((std_map{unseeded.path.string()}));
+}
+
+TEST_CASE("The mapped hash map stores string keys in a pool") {
+  temporary_file file{"stroupo-mapped-string"};
+  constexpr int count = 5000;
+  {
+    stroupo::mapped_hash_map<string, int> map{file.path.string()};
+    for (int i = 0; i < count; ++i) map.insert("key-" + to_string(i), i);
+    for (int i = 0; i < count; i += 3) map.erase("key-" + to_string(i));
+  }
+  stroupo::mapped_hash_map<string, int> map{file.path.string()};
+  CHECK(map.size() == count - (count + 2) / 3);
+  for (int i = 0; i < count; ++i)
+    CHECK(map.contains("key-" + to_string(i)) == (i % 3 != 0));
+  const string buffer = "key-1key-2";
+  CHECK(map.at(string_view{buffer.data(), 5}) == 1);
+  map.reserve(4 * count);
+  CHECK(map.at("key-4999") == 4999);
+  map.insert("a much longer key than all the others", -1);
+  CHECK(map.at("a much longer key than all the others") == -1);
+}
+
+TEST_CASE("The mapped hash map inserts views into its own pool") {
+  temporary_file file{"stroupo-mapped-alias"};
+  stroupo::mapped_hash_map<string, int> map{file.path.string()};
+  const string key(3000, 'k');
+  map.insert(key, 0);
+  // Every prefix is a new key whose view points into the pool. The pool and
+  // the table grow and are remapped while the prefixes are inserted.
+  for (size_t size = 1; size < key.size(); ++size) {
+    string_view stored{};
+    map.for_each([&](string_view k, int) {
+      if (k.size() == key.size()) stored = k;
+    });
+    CHECK(map.insert(stored.substr(0, size), int(size)));
+  }
+  CHECK(map.size() == key.size());
+  for (size_t size = 1; size <= key.size(); ++size)
+    CHECK(map.at(key.substr(0, size)) == int(size % key.size()));
+}
+
+TEST_CASE("The mapped hash map keeps its old table if it cannot grow") {
+  temporary_file file{"stroupo-mapped-growth"};
+  const auto temporary = file.path.string() + ".tmp";
+  stroupo::mapped_hash_map<string, int> map{file.path.string()};
+  for (int i = 0; i < 1000; ++i) map.insert("key-" + to_string(i), i);
+  CHECK(!filesystem::exists(temporary));
+
+  // The grown table cannot be written if a directory has its path.
+  filesystem::create_directory(temporary);
+  const auto capacity = map.capacity();
+  CHECK_THROWS_AS(map.reserve(4 * capacity), std::system_error);
+  CHECK(map.capacity() == capacity);
+  CHECK(map.size() == 1000);
+  for (int i = 0; i < 1000; ++i) CHECK(map.at("key-" + to_string(i)) == i);
+  map.insert("key-1000", 1000);
+  map.flush();
+  filesystem::remove(temporary);
+
+  map.reserve(4 * capacity);
+  CHECK(map.capacity() > capacity);
+  CHECK(!filesystem::exists(temporary));
+  stroupo::mapped_hash_map<string, int> reopened{file.path.string()};
+  CHECK(reopened.capacity() == map.capacity());
+  for (int i = 0; i <= 1000; ++i)
+    CHECK(reopened.at("key-" + to_string(i)) == i);
+}
+
+TEST_CASE("The mapped hash map rejects files of other layouts") {
+  temporary_file file{"stroupo-mapped-layout"};
+  { stroupo::mapped_hash_map<int, int> map{file.path.string()}; }
+  CHECK_THROWS_AS((stroupo::mapped_hash_map<int, double>{file.path.string()}),
+                  std::runtime_error);
+  CHECK_THROWS_AS(
+      (stroupo::mapped_hash_map<string, int>{file.path.string()}),
+      std::runtime_error);
+  CHECK_NOTHROW((stroupo::mapped_hash_map<int, int>{file.path.string()}));
+  CHECK_THROWS_AS((stroupo::mapped_hash_map<int, int>{"/nonexistent/map"}),
+                  std::system_error);
+}
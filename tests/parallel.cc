@@ -0,0 +1,82 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+namespace {
+
+// Maps all keys to a few hash values. Hence, the clusters cross the borders
+// of the regions and wrap around the end of the table.
+struct clustered_hash {
+  size_t operator()(int key) const noexcept {
+    return static_cast<size_t>(key % 8) * 0x9e3779b97f4a7c15ull;
+  }
+};
+
+template <typename Hash, typename... Policies>
+using parallel_map = hashed_policy_map<int, int, Hash, Policies...>;
+
+}  // namespace
+
+TEST_CASE_TEMPLATE(
+    "The hash map is built and rehashed in parallel", map_type,
+    parallel_map<std::hash<int>>,
+    parallel_map<std::hash<int>, stroupo::control_byte_layout>,
+    parallel_map<std::hash<int>, stroupo::robin_hood_probing>,
+    parallel_map<std::hash<int>, stroupo::fibonacci_reduction,
+                 stroupo::stored_hash>,
+    parallel_map<clustered_hash>,
+    parallel_map<clustered_hash, stroupo::control_byte_layout>,
+    parallel_map<clustered_hash, stroupo::robin_hood_probing>,
+    parallel_map<std::hash<int>, stroupo::bitmap_layout<>>,
+    parallel_map<clustered_hash, stroupo::bitmap_layout<>,
+                 stroupo::robin_hood_probing>) {
+  mt19937 rng{random_device{}()};
+  uniform_int_distribution<int> key_dist{-1000, 1000};
+  // The values contain duplicate keys. The last value of a key wins.
+  vector<pair<int, int>> values{};
+  unordered_map<int, int> reference{};
+  for (auto i = 0; i < 3000; ++i) {
+    const auto key = key_dist(rng);
+    values.push_back({key, i});
+    reference[key] = i;
+  }
+  const auto expected = sorted_content(reference);
+
+  for (size_t threads : {1, 3, 8}) {
+    auto map = map_type::build_from(values.begin(), values.end(), threads);
+    REQUIRE(map.size() == reference.size());
+    CHECK(sorted_content(map) == expected);
+    for (const auto& [key, value] : reference) CHECK(map.at(key) == value);
+
+    map.rehash(4 * map.capacity(),
+               stroupo::execution::parallel_policy{threads});
+    REQUIRE(map.size() == reference.size());
+    CHECK(sorted_content(map) == expected);
+    for (const auto& [key, value] : reference) CHECK(map.at(key) == value);
+
+    // The map stays usable for the serial modifiers.
+    for (auto i = 0; i < 2000; i += 2)
+      CHECK(map.erase(i) == reference.count(i));
+    for (auto i = 2000; i < 4000; ++i) map[i] = i;
+    for (auto i = 2000; i < 4000; ++i) CHECK(map.at(i) == i);
+  }
+
+  SUBCASE("The sequenced policy rehashes like rehash.") {
+    auto map = map_type::build_from(values.begin(), values.end());
+    map.rehash(2 * map.capacity(), stroupo::execution::seq);
+    CHECK(sorted_content(map) == expected);
+  }
+}
@@ -0,0 +1,525 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <hash_map/hash.h>
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+namespace {
+
+using node_map = policy_map<int, int>;
+using node_tombstone_map = policy_map<int, int, stroupo::tombstone_erasure>;
+using control_byte_map = policy_map<int, int, stroupo::control_byte_layout>;
+using control_byte_tombstone_map =
+    policy_map<int, int, stroupo::control_byte_layout,
+               stroupo::tombstone_erasure>;
+using robin_hood_map = policy_map<int, int, stroupo::robin_hood_probing>;
+using soa_map = policy_map<int, int, stroupo::soa_layout>;
+using soa_tombstone_map =
+    policy_map<int, int, stroupo::soa_layout, stroupo::tombstone_erasure>;
+using soa_robin_hood_map = policy_map<int, int, stroupo::soa_layout,
+                                      stroupo::robin_hood_probing,
+                                      stroupo::stored_hash>;
+using bitmap_map = policy_map<int, int, stroupo::bitmap_layout<>>;
+using bitmap_robin_hood_map =
+    policy_map<int, int, stroupo::bitmap_layout<>, stroupo::robin_hood_probing>;
+using bitmap_soa_tombstone_map =
+    policy_map<int, int, stroupo::bitmap_layout<stroupo::soa_layout>,
+               stroupo::tombstone_erasure>;
+using incremental_bitmap_map =
+    policy_map<int, int, stroupo::incremental_rehash<2>,
+               stroupo::bitmap_layout<>>;
+// The random keys never reach the sentinel keys.
+using sentinel_map = policy_map<int, int, stroupo::sentinel_layout<-1000000>>;
+using sentinel_tombstone_map =
+    policy_map<int, int, stroupo::sentinel_layout<-1000000, -1000001>,
+               stroupo::tombstone_erasure>;
+
+// Multiplies with an odd constant. Hence, the high bits are well distributed.
+struct multiplicative_hash {
+  size_t operator()(int key) const noexcept {
+    return static_cast<size_t>(key) * 0x9e3779b97f4a7c15ull;
+  }
+};
+
+template <typename Hash, typename... Policies>
+using hashed_map = hashed_policy_map<int, int, Hash, Policies...>;
+
+using power_of_two_map = policy_map<int, int, stroupo::power_of_two_reduction>;
+using fibonacci_map = policy_map<int, int, stroupo::fibonacci_reduction>;
+using fastrange_map =
+    hashed_map<multiplicative_hash, stroupo::fastrange_reduction>;
+using fibonacci_control_byte_map =
+    policy_map<int, int, stroupo::fibonacci_reduction,
+               stroupo::control_byte_layout, stroupo::tombstone_erasure>;
+using power_of_two_robin_hood_map =
+    policy_map<int, int, stroupo::power_of_two_reduction,
+               stroupo::robin_hood_probing>;
+using fastrange_robin_hood_map =
+    hashed_map<multiplicative_hash, stroupo::fastrange_reduction,
+               stroupo::robin_hood_probing>;
+using stored_hash_map = policy_map<int, int, stroupo::stored_hash>;
+using stored_hash_control_byte_map =
+    policy_map<int, int, stroupo::stored_hash, stroupo::control_byte_layout,
+               stroupo::tombstone_erasure>;
+using stored_hash_robin_hood_map =
+    policy_map<int, int, stroupo::stored_hash, stroupo::robin_hood_probing>;
+// Small migration steps let the migrations span many operations.
+using incremental_map = policy_map<int, int, stroupo::incremental_rehash<2>>;
+using incremental_control_byte_map =
+    policy_map<int, int, stroupo::incremental_rehash<2>,
+               stroupo::control_byte_layout, stroupo::tombstone_erasure>;
+using incremental_robin_hood_map =
+    policy_map<int, int, stroupo::incremental_rehash<4>,
+               stroupo::robin_hood_probing, stroupo::stored_hash>;
+
+// Counts its calls to check that stored hash values are not recomputed.
+struct counting_hash {
+  static inline int calls = 0;
+  size_t operator()(const string& key) const {
+    ++calls;
+    return std::hash<string>{}(key);
+  }
+};
+
+template <typename... Policies>
+using counting_string_map =
+    stroupo::hash_map<string, int, counting_hash, std::equal_to<string>,
+                      std::allocator<std::pair<const string, int>>,
+                      Policies...>;
+
+}  // namespace
+
+TEST_CASE_TEMPLATE(
+    "The hash map behaves like std::unordered_map for random operations",
+    map_type, node_map, node_tombstone_map, control_byte_map,
+    control_byte_tombstone_map, robin_hood_map, power_of_two_map,
+    fibonacci_map, fastrange_map, fibonacci_control_byte_map,
+    power_of_two_robin_hood_map, fastrange_robin_hood_map, stored_hash_map,
+    stored_hash_control_byte_map, stored_hash_robin_hood_map, incremental_map,
+    incremental_control_byte_map, incremental_robin_hood_map, sentinel_map,
+    sentinel_tombstone_map, soa_map, soa_tombstone_map, soa_robin_hood_map,
+    bitmap_map, bitmap_robin_hood_map, bitmap_soa_tombstone_map,
+    incremental_bitmap_map) {
+  constexpr auto count = 20000;
+  constexpr auto key_range = 2000;
+  mt19937 rng{random_device{}()};
+  uniform_int_distribution<int> key_dist{-key_range, key_range};
+  uniform_int_distribution<int> operation_dist{0, 3};
+
+  map_type map{};
+  unordered_map<int, int> reference{};
+
+  for (auto i = 0; i < count; ++i) {
+    const auto key = key_dist(rng);
+    switch (operation_dist(rng)) {
+      case 0:
+        map[key] = i;
+        reference[key] = i;
+        break;
+      case 1:
+        CHECK(map.erase(key) == reference.erase(key));
+        break;
+      case 2: {
+        const auto it = map.find(key);
+        const auto ref_it = reference.find(key);
+        REQUIRE((it == map.end()) == (ref_it == reference.end()));
+        if (ref_it != reference.end()) CHECK(it->second == ref_it->second);
+        break;
+      }
+      default:
+        map.insert({key, -i});
+        reference[key] = -i;
+        break;
+    }
+    REQUIRE(map.size() == reference.size());
+  }
+
+  CHECK(sorted_content(map) == sorted_content(reference));
+}
+
+TEST_CASE_TEMPLATE("The hash map stores string keys", map_type,
+                   policy_map<string, int>,
+                   policy_map<string, int, stroupo::control_byte_layout>,
+                   policy_map<string, int, stroupo::robin_hood_probing>,
+                   policy_map<string, int, stroupo::stored_hash>,
+                   policy_map<string, int, stroupo::stored_hash,
+                              stroupo::control_byte_layout>,
+                   policy_map<string, int, stroupo::soa_layout>) {
+  map_type map{};
+  for (auto i = 0; i < 1000; ++i) map[to_string(i) + "-key"] = i;
+  CHECK(map.size() == 1000);
+  for (auto i = 0; i < 1000; ++i) CHECK(map.at(to_string(i) + "-key") == i);
+  CHECK(map.find("missing") == map.end());
+  for (auto i = 0; i < 1000; i += 2) CHECK(map.erase(to_string(i) + "-key"));
+  CHECK(map.size() == 500);
+  for (auto i = 1; i < 1000; i += 2) CHECK(map.at(to_string(i) + "-key") == i);
+}
+
+TEST_CASE_TEMPLATE("The hash map with stored hashes does not recompute them",
+                   map_type, counting_string_map<stroupo::stored_hash>,
+                   counting_string_map<stroupo::stored_hash,
+                                       stroupo::control_byte_layout>,
+                   counting_string_map<stroupo::stored_hash,
+                                       stroupo::robin_hood_probing>) {
+  map_type map{};
+  counting_hash::calls = 0;
+  for (auto i = 0; i < 1000; ++i) map[to_string(i) + "-key"] = i;
+  map.rehash(4 * map.capacity());
+  for (auto i = 0; i < 1000; i += 2) CHECK(map.erase(to_string(i) + "-key"));
+  // Every insertion and erasure hashes its argument exactly once.
+  CHECK(counting_hash::calls == 1500);
+  for (auto i = 1; i < 1000; i += 2) CHECK(map.at(to_string(i) + "-key") == i);
+}
+
+SCENARIO("The hash map with Robin Hood probing runs at high load factors.") {
+  GIVEN("a hash map with Robin Hood probing") {
+    robin_hood_map map{};
+    CHECK(map.max_load_factor() == robin_hood_map::real_type{0.9});
+
+    WHEN("many keys with colliding home indices are inserted") {
+      constexpr auto count = 10000;
+      for (auto i = 0; i < count; ++i) map[i * 64] = i;
+
+      THEN("the load factor stays below its maximum") {
+        CHECK(map.size() == count);
+        CHECK(map.load_factor() < map.max_load_factor());
+        CHECK(map.load_factor() > map.max_load_factor() / 2);
+      }
+
+      THEN("all keys can be found and missing keys are not found") {
+        for (auto i = 0; i < count; ++i) CHECK(map.at(i * 64) == i);
+        for (auto i = 0; i < count; ++i)
+          CHECK(map.find(i * 64 + 1) == map.end());
+      }
+
+      THEN("erasing keys keeps the other keys accessible") {
+        for (auto i = 0; i < count; i += 3) CHECK(map.erase(i * 64) == 1);
+        for (auto i = 0; i < count; ++i) {
+          if (i % 3 == 0)
+            CHECK(map.find(i * 64) == map.end());
+          else
+            CHECK(map.at(i * 64) == i);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE_TEMPLATE(
+    "The hash map keeps a power of two capacity for masking reductions",
+    map_type, power_of_two_map, fibonacci_map, fibonacci_control_byte_map,
+    power_of_two_robin_hood_map) {
+  const auto is_power_of_two = [](auto n) { return n && !(n & (n - 1)); };
+  map_type map{};
+  CHECK(is_power_of_two(map.capacity()));
+
+  for (auto i = 0; i < 1000; ++i) {
+    map[i] = i;
+    REQUIRE(is_power_of_two(map.capacity()));
+  }
+
+  map.reserve(3000);
+  CHECK(is_power_of_two(map.capacity()));
+  CHECK(map.capacity() * map.max_load_factor() >= 3000);
+
+  map.rehash(5000);
+  CHECK(is_power_of_two(map.capacity()));
+  CHECK(map.capacity() >= 5000);
+
+  for (auto i = 0; i < 1000; ++i) CHECK(map.at(i) == i);
+}
+
+TEST_CASE_TEMPLATE("The hash map with incremental rehashing stays consistent",
+                   map_type, incremental_map, incremental_control_byte_map,
+                   incremental_robin_hood_map, incremental_bitmap_map) {
+  map_type map{};
+  auto count = 0;
+  // Tiny tables may grow again before their migration is complete.
+  for (; count < 100 || !map.rehashing(); ++count) map[count] = count;
+  const auto capacity = map.capacity();
+
+  SUBCASE("while entries are migrated.") {
+    CHECK(distance(map.begin(), map.end()) == count);
+    auto visited = 0;
+    map.for_each([&](int key, int& value) { visited += (key == value); });
+    CHECK(visited == count);
+    for (auto i = 0; i < count; ++i) CHECK(map.at(i) == i);
+    CHECK(map.find(count) == map.end());
+    CHECK(!map.contains(-1));
+    // Erasing old entries migrates them first.
+    for (auto i = 0; i < count; i += 3) CHECK(map.erase(i) == 1);
+    for (auto i = 0; i < count; ++i) CHECK(map.contains(i) == (i % 3 != 0));
+    CHECK(map.size() == static_cast<size_t>(count - (count + 2) / 3));
+  }
+
+  SUBCASE("until the migration is complete.") {
+    auto i = count;
+    for (; map.rehashing(); ++i) map[i] = i;
+    CHECK(map.capacity() == capacity);
+    CHECK(map.size() == static_cast<size_t>(i));
+    for (auto j = 0; j < i; ++j) CHECK(map.at(j) == j);
+  }
+
+  SUBCASE("when rehash is called explicitly.") {
+    map.rehash(4 * capacity);
+    CHECK(!map.rehashing());
+    CHECK(map.size() == static_cast<size_t>(count));
+    for (auto i = 0; i < count; ++i) CHECK(map.at(i) == i);
+  }
+}
+
+namespace {
+
+// Counts its default constructions, i.e. the empty slots which are
+// initialized.
+struct slot_counted {
+  static inline size_t constructions = 0;
+  slot_counted() { ++constructions; }
+  explicit slot_counted(int value) : value{value} {}
+  int value{};
+};
+
+// Sequential keys would form a single cluster which is migrated at once.
+template <typename... Policies>
+using counted_map =
+    hashed_policy_map<int, slot_counted, stroupo::murmur_hash, Policies...>;
+
+// The largest number of slots which one insertion initializes. Migrated
+// slots are reset to empty ones as well.
+template <typename Map>
+size_t max_initialized_slots(int count) {
+  Map map{};
+  size_t result = 0;
+  for (auto i = 0; i < count; ++i) {
+    slot_counted::constructions = 0;
+    map.emplace(i, slot_counted{i});
+    result = max(result, slot_counted::constructions);
+  }
+  CHECK(map.size() == static_cast<size_t>(count));
+  CHECK(map.at(count / 2).value == count / 2);
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE(
+    "The hash map with incremental rehashing initializes its tables in steps") {
+  constexpr auto count = 1 << 18;
+  // A full rehash initializes the whole new table at once.
+  CHECK(max_initialized_slots<counted_map<>>(count) >= count);
+  CHECK(max_initialized_slots<counted_map<stroupo::incremental_rehash<>>>(
+            count) < 1000);
+  CHECK(max_initialized_slots<counted_map<stroupo::incremental_rehash<>,
+                                          stroupo::control_byte_layout>>(
+            count) < 1000);
+  CHECK(max_initialized_slots<
+            counted_map<stroupo::incremental_rehash<>, stroupo::soa_layout,
+                        stroupo::robin_hood_probing>>(count) < 1000);
+}
+
+TEST_CASE_TEMPLATE("The hash map visits the entries of sparse tables",
+                   map_type, node_map, control_byte_map, bitmap_map,
+                   bitmap_robin_hood_map, bitmap_soa_tombstone_map) {
+  map_type map{};
+  map.reserve(10000);
+  for (auto i = 0; i < 3000; ++i) map[i] = i;
+  for (auto i = 0; i < 3000; ++i)
+    if (i % 97 != 0) map.erase(i);
+  vector<int> expected{};
+  for (auto i = 0; i < 3000; i += 97) expected.push_back(i);
+
+  vector<int> keys{};
+  for (auto it = map.begin(); it != map.end(); ++it) keys.push_back(it->first);
+  sort(begin(keys), end(keys));
+  CHECK(keys == expected);
+
+  keys.clear();
+  map.for_each([&](int key, int& value) {
+    keys.push_back(key);
+    value = -key;
+  });
+  sort(begin(keys), end(keys));
+  CHECK(keys == expected);
+
+  keys.clear();
+  long sum = 0;
+  const auto& const_map = map;
+  const_map.for_each_batch(
+      [&](const int* const* k, const int* const* v, size_t count) {
+        CHECK(count <= map_type::visit_batch_size);
+        for (size_t i = 0; i < count; ++i) {
+          sum += *v[i];
+          keys.push_back(*k[i]);
+        }
+      });
+  sort(begin(keys), end(keys));
+  CHECK(keys == expected);
+  CHECK(sum == -accumulate(begin(expected), end(expected), 0L));
+}
+
+TEST_CASE_TEMPLATE("The hash map visits move-only values in batches",
+                   map_type, stroupo::hash_map<int, unique_ptr<int>>,
+                   policy_map<int, unique_ptr<int>, stroupo::soa_layout>) {
+  map_type map{};
+  for (auto i = 0; i < 200; ++i) map[i] = make_unique<int>(2 * i);
+  long sum = 0;
+  size_t visited = 0;
+  map.for_each_batch([&](const int* const* k, const unique_ptr<int>* const* v,
+                         size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      CHECK(**v[i] == 2 * *k[i]);
+      sum += **v[i];
+    }
+    visited += count;
+  });
+  CHECK(visited == map.size());
+  CHECK(sum == 2 * 199 * 200 / 2);
+}
+
+TEST_CASE("The SoA layout yields references to its keys and values") {
+  using map_type = policy_map<int, vector<int>, stroupo::soa_layout>;
+  map_type map{};
+  for (auto i = 0; i < 100; ++i) map[i] = vector<int>(i, i);
+  for (auto&& [key, value] : map) value.push_back(key);
+  for (auto it = map.begin(); it != map.end(); ++it)
+    CHECK(it->second.size() == static_cast<size_t>(it->first) + 1);
+  const auto& const_map = map;
+  const map_type::const_reference entry = *const_map.find(42);
+  CHECK(entry.first == 42);
+  CHECK(entry.second.back() == 42);
+  const pair<int, vector<int>> copy = *map.find(3);
+  CHECK(copy == pair<int, vector<int>>{3, {3, 3, 3, 3}});
+}
+
+TEST_CASE("The sentinel layout rejects its sentinel keys") {
+  using map_type =
+      policy_map<long, long, stroupo::sentinel_layout<0, -1>,
+                 stroupo::tombstone_erasure, stroupo::stored_hash>;
+  map_type map{};
+  for (long key = 1; key <= 100; ++key) map[key] = key;
+  CHECK_THROWS_AS(map.insert({0, 1}), std::invalid_argument);
+  CHECK_THROWS_AS(map[-1], std::invalid_argument);
+  CHECK(map.size() == 100);
+  CHECK(map.find(0) == map.end());
+  CHECK(map.find(-1) == map.end());
+  for (long key = 1; key <= 100; key += 2) CHECK(map.erase(key) == 1);
+  CHECK(map.find(-1) == map.end());
+  for (long key = 1; key <= 100; ++key)
+    CHECK(map.contains(key) == (key % 2 == 0));
+}
+
+// Strided keys collide in the low bits. The identity exposes that.
+struct identity_hash {
+  size_t operator()(int key) const noexcept { return key; }
+};
+
+TEST_CASE_TEMPLATE("The hash map collects statistics", map_type,
+                   hashed_map<identity_hash, stroupo::power_of_two_reduction,
+                              stroupo::collect_stats>,
+                   hashed_map<identity_hash, stroupo::power_of_two_reduction,
+                              stroupo::collect_stats,
+                              stroupo::control_byte_layout,
+                              stroupo::tombstone_erasure>,
+                   hashed_map<identity_hash, stroupo::power_of_two_reduction,
+                              stroupo::collect_stats,
+                              stroupo::robin_hood_probing>) {
+  map_type map{};
+  for (auto i = 0; i < 1000; ++i) map[i << 8] = i;
+  for (auto i = 0; i < 1000; ++i) CHECK(map.at(i << 8) == i);
+  for (auto i = 0; i < 1000; i += 2) CHECK(map.erase(i << 8) == 1);
+
+  const auto stats = map.stats();
+  CHECK(stats.size == 500);
+  CHECK(stats.capacity == map.capacity());
+  CHECK(stats.rehashes > 0);
+  CHECK(stats.probes >= 2500);
+  CHECK(stats.hits >= 1500);
+  CHECK(stats.collisions > 0);
+  CHECK(stats.average_probe_length() > 2);
+  CHECK(stats.max_probe_length <= stats.probe_length_sum);
+  uint64_t probes = 0;
+  for (const auto count : stats.probe_histogram) probes += count;
+  CHECK(probes == stats.probes);
+
+  // Every entry and every full slot appears in the histograms.
+  stringstream distribution{};
+  map.dump_distribution(distribution);
+  size_t entries = 0;
+  size_t slots = 0;
+  auto* total = &entries;
+  for (string line; getline(distribution, line);) {
+    if (line == "# cluster length\tclusters") total = &slots;
+    if (line[0] == '#') continue;
+    stringstream fields{line};
+    size_t n, count;
+    fields >> n >> count;
+    *total += (total == &slots) ? n * count : count;
+  }
+  CHECK(entries == 500);
+  CHECK(slots == 500);
+
+  map.reset_stats();
+  CHECK(map.stats().probes == 0);
+}
+
+TEST_CASE("The hash map does not collect statistics by default") {
+  node_map map{};
+  for (auto i = 0; i < 1000; ++i) map[i] = i;
+  const auto stats = map.stats();
+  CHECK(stats.size == 1000);
+  CHECK(stats.probes == 0);
+  CHECK(stats.rehashes == 0);
+}
+
+TEST_CASE_TEMPLATE("The hash map reports its memory usage", map_type,
+                   node_map, control_byte_map, soa_map, bitmap_map,
+                   sentinel_map, incremental_map) {
+  map_type map{};
+  for (auto i = 0; i < 1000; ++i) map[i] = i;
+  const auto memory = map.memory_usage();
+  CHECK(memory.table_bytes >= map.capacity() * 2 * sizeof(int));
+  CHECK(memory.padding_bytes < memory.table_bytes);
+  CHECK(memory.key_heap_bytes == 0);
+  CHECK(memory.total() == memory.table_bytes);
+}
+
+TEST_CASE("The hash map counts the heap memory of string keys") {
+  policy_map<string, int> map{};
+  map["short"] = 1;
+  CHECK(map.memory_usage().key_heap_bytes == 0);
+  map[string(100, 'a')] = 2;
+  const auto memory = map.memory_usage();
+  CHECK(memory.key_heap_bytes >= 101);
+  CHECK(memory.key_heap_bytes <= 256);
+  CHECK(memory.total() == memory.table_bytes + memory.key_heap_bytes);
+}
+
+TEST_CASE("The Fibonacci reduction spreads sequential keys over the table") {
+  stroupo::fibonacci_reduction reduction{1024};
+  vector<size_t> indices{};
+  for (size_t i = 0; i < 1024; ++i) indices.push_back(reduction.index(i));
+  sort(begin(indices), end(indices));
+  const auto distinct =
+      distance(begin(indices), unique(begin(indices), end(indices)));
+  CHECK(distinct > 512);
+  CHECK(indices.back() < 1024);
+}
+
+TEST_CASE("The fastrange reduction maps hash values into the table") {
+  stroupo::fastrange_reduction reduction{1000};
+  CHECK(reduction.index(0) == 0);
+  CHECK(reduction.index(~size_t{0}) == 999);
+  CHECK(reduction.index(~size_t{0} / 2) == 499);
+}
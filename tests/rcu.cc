@@ -0,0 +1,95 @@
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <hash_map/rcu_hash_map.h>
+
+using namespace std;
+
+namespace {
+
+using rcu_map = stroupo::rcu_hash_map<int, int>;
+
+}  // namespace
+
+TEST_CASE("The RCU hash map publishes the changes of its writer") {
+  rcu_map map{};
+  CHECK(map.empty());
+  map.insert({1, 10});
+  map.insert({2, 20});
+  CHECK(map.size() == 2);
+  CHECK(map.contains(1));
+
+  auto value = 0;
+  CHECK(map.find(2, [&](int v) { value = v; }));
+  CHECK(value == 20);
+  CHECK(!map.find(3, [&](int v) { value = v; }));
+
+  CHECK(map.erase(1) == 1);
+  CHECK(map.erase(1) == 0);
+  CHECK(!map.contains(1));
+
+  map.update([](rcu_map::map_type& m) {
+    for (auto i = 0; i < 100; ++i) m[i] = -i;
+  });
+  CHECK(map.size() == 100);
+
+  map.publish(rcu_map::map_type{{5, 5}});
+  CHECK(map.size() == 1);
+  CHECK(map.read([](const rcu_map::map_type& m) { return m.at(5); }) == 5);
+}
+
+TEST_CASE("The RCU hash map gives readers consistent snapshots under stress") {
+  constexpr auto reader_count = 8;
+  constexpr auto key_count = 256;
+  constexpr auto versions = 200;
+
+  // Every snapshot maps all keys to the version which created it.
+  const auto make_version = [](int version) {
+    rcu_map::map_type map{};
+    for (auto i = 0; i < key_count; ++i) map[i] = version;
+    return map;
+  };
+  rcu_map map{make_version(0)};
+
+  atomic<bool> done{false};
+  atomic<int> inconsistent{0};
+  atomic<long> reads{0};
+  vector<thread> readers{};
+  for (auto r = 0; r < reader_count; ++r) {
+    readers.emplace_back([&, r] {
+      auto last_version = 0;
+      while (!done) {
+        const auto consistent = map.read([&](const rcu_map::map_type& m) {
+          const auto version = m.at(r % key_count);
+          if (version < last_version) return false;
+          last_version = version;
+          if (m.size() != key_count) return false;
+          for (const auto& e : m)
+            if (e.second != version) return false;
+          return true;
+        });
+        if (!consistent) ++inconsistent;
+        ++reads;
+      }
+    });
+  }
+
+  for (auto v = 1; v <= versions; ++v) {
+    if (v % 2)
+      map.publish(make_version(v));
+    else
+      map.update([v](rcu_map::map_type& m) {
+        for (auto i = 0; i < key_count; ++i) m[i] = v;
+      });
+  }
+  done = true;
+  for (auto& t : readers) t.join();
+
+  CHECK(inconsistent == 0);
+  CHECK(reads > 0);
+  CHECK(map.read([](const rcu_map::map_type& m) { return m.at(0); }) ==
+        versions);
+}
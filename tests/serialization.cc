@@ -0,0 +1,115 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hash_map/hash_map.h>
+
+#include "helpers.h"
+
+using namespace std;
+
+TEST_CASE_TEMPLATE("The hash map restores its snapshots", map_type,
+                   policy_map<int, int>,
+                   policy_map<int, int, stroupo::control_byte_layout>,
+                   policy_map<int, int, stroupo::robin_hood_probing>,
+                   policy_map<int, int, stroupo::tombstone_erasure>,
+                   policy_map<int, int, stroupo::incremental_rehash<2>>,
+                   policy_map<string, string, stroupo::stored_hash>) {
+  using key_type = typename map_type::key_type;
+  using mapped_type = typename map_type::mapped_type;
+  const auto key = [](int i) {
+    if constexpr (is_same_v<key_type, string>)
+      return "key-" + to_string(i);
+    else
+      return i;
+  };
+  const auto value = [](int i) {
+    if constexpr (is_same_v<mapped_type, string>)
+      return string(i % 50, 'v');
+    else
+      return -i;
+  };
+  map_type map{};
+  for (int i = 0; i < 5000; ++i) map[key(i)] = value(i);
+  for (int i = 0; i < 5000; i += 7) map.erase(key(i));
+
+  map_type copy{};
+  copy[key(-1)] = value(1);
+  istringstream in{snapshot(map)};
+  copy.load(in);
+  CHECK(copy.size() == map.size());
+  CHECK(sorted_content(copy) == sorted_content(map));
+  CHECK(!copy.contains(key(-1)));
+  for (int i = 0; i < 5000; ++i)
+    CHECK(copy.contains(key(i)) == (i % 7 != 0));
+
+  // The restored map stays usable for all modifiers.
+  for (int i = 0; i < 5000; i += 2) copy.erase(key(i));
+  for (int i = 5000; i < 6000; ++i) copy[key(i)] = value(i);
+  for (int i = 1; i < 6000; i += 2)
+    CHECK(copy.contains(key(i)) == (i >= 5000 || i % 7 != 0));
+}
+
+TEST_CASE("The hash map reinserts snapshots of other policies") {
+  policy_map<int, int> map{};
+  for (int i = 0; i < 3000; ++i) map[i * 3] = i;
+
+  policy_map<int, int, stroupo::control_byte_layout,
+             stroupo::power_of_two_reduction>
+      other{};
+  istringstream in{snapshot(map)};
+  other.load(in);
+  CHECK(sorted_content(other) == sorted_content(map));
+  for (int i = 0; i < 3000; ++i) CHECK(other.at(i * 3) == i);
+
+  istringstream again{snapshot(other)};
+  policy_map<int, int> round_trip{};
+  round_trip.load(again);
+  CHECK(sorted_content(round_trip) == sorted_content(map));
+  // Snapshots of the same policies restore the capacity.
+  istringstream same{snapshot(map)};
+  round_trip.load(same);
+  CHECK(round_trip.capacity() == map.capacity());
+}
+
+TEST_CASE("The hash map rejects corrupt snapshots") {
+  policy_map<int, int> map{};
+  for (int i = 0; i < 20000; ++i) map[i] = i;
+  const auto data = snapshot(map);
+  policy_map<int, int> target{{1, 1}, {2, 2}};
+
+  SUBCASE("with a modified byte.") {
+    auto corrupt = data;
+    corrupt[corrupt.size() / 2] ^= 1;
+    istringstream in{corrupt};
+    CHECK_THROWS_AS(target.load(in), std::runtime_error);
+  }
+
+  SUBCASE("which are truncated.") {
+    istringstream in{data.substr(0, data.size() - 20)};
+    CHECK_THROWS_AS(target.load(in), std::runtime_error);
+  }
+
+  SUBCASE("of other types.") {
+    istringstream in{data};
+    policy_map<int, long> other{};
+    CHECK_THROWS_AS(other.load(in), std::runtime_error);
+  }
+
+  SUBCASE("which are no snapshots.") {
+    istringstream in{"not a snapshot of a hash map"};
+    CHECK_THROWS_AS(target.load(in), std::runtime_error);
+  }
+
+  // Failed loads leave the map unchanged.
+  CHECK(target.size() == 2);
+  CHECK(target.at(1) == 1);
+  CHECK(target.at(2) == 2);
+}
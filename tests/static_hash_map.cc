@@ -0,0 +1,61 @@
+#include <doctest/doctest.h>
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include <hash_map/static_hash_map.h>
+
+using namespace std;
+
+namespace {
+
+constexpr auto methods = stroupo::make_static_hash_map<string_view, int>(
+    {{"GET", 1}, {"HEAD", 2}, {"POST", 3}, {"PUT", 4}, {"DELETE", 5}});
+
+static_assert(methods.size() == 5);
+static_assert(methods.at("PUT") == 4);
+static_assert(methods.contains("DELETE"));
+static_assert(!methods.contains("PATCH"));
+static_assert(!methods.contains(""));
+
+template <size_t... I>
+constexpr array<pair<int, int>, sizeof...(I)> squares(index_sequence<I...>) {
+  return {{{int(I * I), int(I)}...}};
+}
+
+constexpr size_t square_count = 500;
+constexpr stroupo::static_hash_map<int, int, square_count> square_roots{
+    squares(make_index_sequence<square_count>{})};
+
+static_assert(square_roots.at(49 * 49) == 49);
+static_assert(!square_roots.contains(2));
+
+constexpr stroupo::static_hash_map<int, int, 0> nothing{{}};
+static_assert(nothing.empty() && !nothing.contains(0));
+
+}  // namespace
+
+TEST_CASE("The static hash map finds every key and nothing else") {
+  size_t visited = 0;
+  for (const auto& [key, value] : square_roots) {
+    CHECK(key == value * value);
+    CHECK(square_roots.find(key)->second == value);
+    ++visited;
+  }
+  CHECK(visited == square_count);
+  for (int i = 0; i < 1000; ++i)
+    CHECK(square_roots.count(i * i + 1) == (i == 0 ? 1u : 0u));
+  CHECK(methods.find("GE") == methods.end());
+  CHECK_THROWS_AS(methods.at("PATCH"), std::out_of_range);
+}
+
+TEST_CASE("The static hash map rejects duplicate keys") {
+  using map_type = stroupo::static_hash_map<int, int, 3>;
+  CHECK_THROWS_AS(map_type({{{1, 1}, {2, 2}, {1, 3}}}),
+                  std::invalid_argument);
+  const map_type map{{{{1, 1}, {2, 2}, {3, 3}}}};
+  CHECK(map.at(3) == 3);
+}